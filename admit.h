@@ -0,0 +1,185 @@
+#ifndef __SEGO_ADMIT_H
+#define __SEGO_ADMIT_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "enums.h"
+#include "config.h"
+#include "scheduler.h"
+#include "park.h"
+
+    typedef enum
+    {
+        __SG_ADMIT_QUEUE,
+        __SG_ADMIT_TRY,
+        __SG_ADMIT_BLOCK
+    } __sgAdmitPolicy;
+
+    typedef struct __sgAdmitEntry
+    {
+        void *rt;
+        sgRoutine fn;
+        void *arg;
+        sgAttr attr;
+        struct __sgAdmitEntry *next;
+    } __sgAdmitEntry;
+
+    typedef struct
+    {
+        pthread_mutex_t lock;
+        uint64_t max;
+        uint64_t maxQueued;
+        uint64_t active;
+        uint64_t nQueued;
+        uint64_t queuedTotal;
+        uint64_t rejected;
+        __sgAdmitEntry *head;
+        __sgAdmitEntry *tail;
+        __sgWaitList waiters;
+    } __sgAdmit;
+
+    /*
+     * @brief   Initializes the admission control of a runtime.
+     * @param   a the admission control
+     * @param   max the maximum number of routines admitted at once, `0` for no limit
+     * @param   maxQueued the maximum number of spawns waiting for admission, `0` for no limit
+     * @return  `SG_ERR_PTHREAD` if the lock could not be initialized. `SG_OK` if ok.
+     */
+    sgReturnType __sgAdmitInit(__sgAdmit *a, uint64_t max, uint64_t maxQueued)
+    {
+        if (pthread_mutex_init(&a->lock, NULL) != 0)
+            return SG_ERR_PTHREAD;
+
+        a->max = max;
+        a->maxQueued = maxQueued;
+        a->active = 0;
+        a->nQueued = 0;
+        a->queuedTotal = 0;
+        a->rejected = 0;
+        a->head = NULL;
+        a->tail = NULL;
+        a->waiters.head = NULL;
+        a->waiters.tail = NULL;
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Releases the admission control of a runtime, dropping the spawns still waiting for admission.
+     * @param   a the admission control
+     * @return  None.
+     */
+    void __sgAdmitDeinit(__sgAdmit *a)
+    {
+        while (a->head != NULL)
+        {
+            __sgAdmitEntry *next = a->head->next;
+            free(a->head);
+            a->head = next;
+        }
+
+        pthread_mutex_destroy(&a->lock);
+    }
+
+    /*
+     * @brief   Admits a spawn, queues it, or refuses it, depending on the policy.
+     * @param   a the admission control
+     * @param   e the spawn, owned by the queue if it gets queued
+     * @param   policy `__SG_ADMIT_QUEUE` to queue it when the limit is reached, `__SG_ADMIT_TRY` to refuse it, `__SG_ADMIT_BLOCK` to wait for a free slot
+     * @param   timeout the timeout of `__SG_ADMIT_BLOCK`, `-1` for infinite wait
+     * @return  `SG_OK` if admitted, in which case the caller starts it. `SG_NOTHING` if queued. `SG_REJECTED` if refused. `SG_TIMEOUT` if timeout.
+     */
+    sgReturnType __sgAdmitAcquire(__sgAdmit *a, __sgAdmitEntry *e, __sgAdmitPolicy policy, int64_t timeout)
+    {
+        int64_t deadline = (timeout >= 0) ? __sgMonoNanos() + timeout : -1;
+        sgReturnType ret = SG_OK;
+
+        pthread_mutex_lock(&a->lock);
+        while (a->active >= a->max || a->nQueued > 0)
+        {
+            if (policy == __SG_ADMIT_TRY || (policy == __SG_ADMIT_QUEUE && a->maxQueued != 0 && a->nQueued >= a->maxQueued))
+            {
+                a->rejected += 1;
+                ret = SG_REJECTED;
+                break;
+            }
+
+            if (policy == __SG_ADMIT_QUEUE)
+            {
+                e->next = NULL;
+                if (a->tail == NULL)
+                    a->head = e;
+                else
+                    a->tail->next = e;
+                a->tail = e;
+                a->nQueued += 1;
+                a->queuedTotal += 1;
+                ret = SG_NOTHING;
+                break;
+            }
+
+            int64_t remaining = -1;
+            if (deadline >= 0)
+            {
+                remaining = deadline - __sgMonoNanos();
+                if (remaining <= 0)
+                {
+                    ret = SG_TIMEOUT;
+                    break;
+                }
+            }
+
+            __sgParker p;
+            __sgWaitLink link;
+            __sgParkerInit(&p);
+            __sgWaitListAdd(&a->waiters, &link, &p, a);
+            __sgParkerWait(&p, &a->lock, remaining);
+
+            pthread_mutex_lock(&a->lock);
+            __sgWaitListRemove(&a->waiters, &link);
+        }
+
+        if (ret == SG_OK)
+            a->active += 1;
+        pthread_mutex_unlock(&a->lock);
+
+        return ret;
+    }
+
+    /*
+     * @brief   Frees the slot of a finished routine, or hands it over to the oldest queued spawn.
+     * @param   a the admission control
+     * @return  The queued spawn that now owns the slot and must be started, or `NULL` if none was queued.
+     */
+    __sgAdmitEntry *__sgAdmitRelease(__sgAdmit *a)
+    {
+        pthread_mutex_lock(&a->lock);
+
+        __sgAdmitEntry *e = a->head;
+        if (e != NULL)
+        {
+            a->head = e->next;
+            if (a->head == NULL)
+                a->tail = NULL;
+            a->nQueued -= 1;
+        }
+        else
+        {
+            a->active -= 1;
+            __sgWaitListWakeOne(&a->waiters, a);
+        }
+
+        pthread_mutex_unlock(&a->lock);
+        return e;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef __SEGO_ALLOC_H
+#define __SEGO_ALLOC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdlib.h>
+
+#if defined(__GLIBC__) && !defined(__USE_XOPEN2K)
+#error "sego needs posix_memalign(): define _DEFAULT_SOURCE (or _POSIX_C_SOURCE=200112L), or include sego.h before any system header"
+#endif
+
+    /*
+     * @brief   Allocates memory aligned to a boundary, to be released with `free()`.
+     * @param   align the alignment, a power of two and a multiple of `sizeof(void *)`
+     * @param   size the size, which need not be a multiple of the alignment
+     * @return  The pointer to the memory, or `NULL` if failed.
+     * @note    Built on `posix_memalign()` rather than `aligned_alloc()`, which is only declared in C11 mode.
+     */
+    void *__sgAlignedAlloc(size_t align, size_t size)
+    {
+        void *p = NULL;
+        if (posix_memalign(&p, align, size) != 0)
+            return NULL;
+
+        return p;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
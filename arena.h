@@ -0,0 +1,191 @@
+#ifndef __SEGO_ARENA_H
+#define __SEGO_ARENA_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "enums.h"
+#include "alloc.h"
+
+#define SG_ARENA_CHUNK (64UL * 1024UL)
+#define __SG_ARENA_ALIGN 16UL
+
+    typedef struct __sgArenaChunk
+    {
+        struct __sgArenaChunk *next;
+        size_t size;
+    } __sgArenaChunk;
+
+    typedef struct
+    {
+        char *cur;
+        char *end;
+        __sgArenaChunk *first;
+        __sgArenaChunk *extra;
+        size_t chunkSize;
+    } sgArena;
+
+    __thread sgArena *__sgRoutineArenaTls = NULL;
+    __thread sgArena *__sgArenaSpare = NULL;
+
+    /*
+     * @brief   Rounds a size up to the arena alignment.
+     * @param   size the size
+     * @return  The rounded size.
+     */
+    size_t __sgArenaRound(size_t size)
+    {
+        return (size + __SG_ARENA_ALIGN - 1) & ~(__SG_ARENA_ALIGN - 1);
+    }
+
+    /*
+     * @brief   Creates an arena for bump-pointer allocation. The arena header lives in its first chunk.
+     * @param   chunkSize the size of each chunk, `0` for `SG_ARENA_CHUNK`
+     * @return  The pointer to the arena (`sgArena`) instance, or `NULL` if failed.
+     */
+    sgArena *sgArenaCreate(size_t chunkSize)
+    {
+        size_t head = __sgArenaRound(sizeof(__sgArenaChunk)) + __sgArenaRound(sizeof(sgArena));
+        if (chunkSize == 0)
+            chunkSize = SG_ARENA_CHUNK;
+        if (chunkSize < 2 * head)
+            chunkSize = 2 * head;
+
+        __sgArenaChunk *c = (__sgArenaChunk *)__sgAlignedAlloc(__SG_ARENA_ALIGN, __sgArenaRound(chunkSize));
+        if (!c)
+            return NULL;
+
+        c->next = NULL;
+        c->size = __sgArenaRound(chunkSize);
+
+        sgArena *a = (sgArena *)((char *)c + __sgArenaRound(sizeof(__sgArenaChunk)));
+        a->first = c;
+        a->extra = NULL;
+        a->chunkSize = c->size;
+        a->cur = (char *)c + head;
+        a->end = (char *)c + c->size;
+        return a;
+    }
+
+    /*
+     * @brief   Allocates memory from the arena. It is released all at once by `sgArenaReset()` or `sgArenaDestroy()`, never one by one.
+     * @param   a the arena instance
+     * @param   size the size
+     * @return  The pointer to the memory, aligned to 16 bytes, or `NULL` if failed.
+     * @note    An arena is not thread-safe. Allocations larger than a quarter of a chunk get a chunk of their own.
+     */
+    void *sgArenaAlloc(sgArena *a, size_t size)
+    {
+        if (a == NULL)
+            return NULL;
+
+        size_t off = __sgArenaRound(sizeof(__sgArenaChunk));
+        if (size > SIZE_MAX - off - __SG_ARENA_ALIGN)
+            return NULL;
+
+        size = __sgArenaRound((size == 0) ? 1 : size);
+        if ((size_t)(a->end - a->cur) >= size)
+        {
+            void *p = a->cur;
+            a->cur += size;
+            return p;
+        }
+
+        uint8_t large = (size > a->chunkSize / 4) ? 0x01 : 0x00;
+        size_t total = __sgArenaRound(large ? off + size : a->chunkSize);
+
+        __sgArenaChunk *c = (__sgArenaChunk *)__sgAlignedAlloc(__SG_ARENA_ALIGN, total);
+        if (!c)
+            return NULL;
+
+        c->next = a->extra;
+        c->size = total;
+        a->extra = c;
+
+        char *p = (char *)c + off;
+        if (!large)
+        {
+            a->cur = p + size;
+            a->end = (char *)c + total;
+        }
+        return p;
+    }
+
+    /*
+     * @brief   Releases every allocation of the arena at once, keeping its first chunk for reuse.
+     * @param   a the arena instance
+     * @return  None.
+     */
+    void sgArenaReset(sgArena *a)
+    {
+        if (a == NULL)
+            return;
+
+        while (a->extra != NULL)
+        {
+            __sgArenaChunk *next = a->extra->next;
+            free(a->extra);
+            a->extra = next;
+        }
+
+        a->cur = (char *)a->first + __sgArenaRound(sizeof(__sgArenaChunk)) + __sgArenaRound(sizeof(sgArena));
+        a->end = (char *)a->first + a->first->size;
+    }
+
+    /*
+     * @brief   Destroys the arena and every allocation made from it.
+     * @param   a the arena instance
+     * @return  None.
+     */
+    void sgArenaDestroy(sgArena *a)
+    {
+        if (a == NULL)
+            return;
+
+        sgArenaReset(a);
+        free(a->first);
+    }
+
+    /*
+     * @brief   Takes an arena for a routine, reusing the calling thread's spare one if there is.
+     * @param   none
+     * @return  The pointer to the arena, or `NULL` if failed.
+     */
+    sgArena *__sgArenaAcquire()
+    {
+        sgArena *a = __sgArenaSpare;
+        if (a != NULL)
+        {
+            __sgArenaSpare = NULL;
+            return a;
+        }
+
+        return sgArenaCreate(0);
+    }
+
+    /*
+     * @brief   Releases the arena of a finished routine, keeping it as the calling thread's spare one if there is none yet.
+     * @param   a the arena, can be `NULL`
+     * @return  None.
+     */
+    void __sgArenaRelease(sgArena *a)
+    {
+        if (a == NULL)
+            return;
+
+        sgArenaReset(a);
+        if (__sgArenaSpare == NULL)
+            __sgArenaSpare = a;
+        else
+            sgArenaDestroy(a);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "sego.h"
+#include "bench/linked_queue.h"
+#include <stdio.h>
+
+#define ITEMS 20000000
+
+typedef struct
+{
+    char bytes[32];
+} item_t;
+
+/*
+ * @brief   Times the ring-backed `sgQueue` against the linked-list queue it replaced, queueing 32-byte items and draining the queue every 4th one.
+ * @param   none
+ * @return  `0`.
+ */
+int main()
+{
+    item_t in = {{0}}, out;
+
+    for (size_t cap = 1; cap <= 1024; cap *= 32)
+    {
+        sgLinkedQueue *l = sgLinkedQueueCreate(sizeof(item_t), cap);
+        int64_t start = __sgMonoNanos();
+        for (size_t i = 0; i < ITEMS; ++i)
+        {
+            in.bytes[0] = (char)i;
+            sgLinkedQueueQueue(l, &in);
+            if ((i & 3) == 3)
+                while (sgLinkedQueueDequeue(l, &out) == SG_OK)
+                    ;
+        }
+        double linked = (double)(__sgMonoNanos() - start) / ITEMS;
+        sgLinkedQueueDestroy(l);
+
+        sgQueue *q = sgQueueCreate(sizeof(item_t), cap);
+        start = __sgMonoNanos();
+        for (size_t i = 0; i < ITEMS; ++i)
+        {
+            in.bytes[0] = (char)i;
+            sgQueueQueue(q, &in);
+            if ((i & 3) == 3)
+                while (sgQueueDequeue(q, &out) == SG_OK)
+                    ;
+        }
+        double ring = (double)(__sgMonoNanos() - start) / ITEMS;
+        sgQueueDestroy(q);
+
+        printf("bufferSize %4zu: linked %.1f ns/item, ring %.1f ns/item\n", cap, linked, ring);
+    }
+
+    return 0;
+}
\ No newline at end of file
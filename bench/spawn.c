@@ -0,0 +1,58 @@
+#include "sego.h"
+#include <stdio.h>
+
+#define SPAWNS 5000
+
+static int64_t total = 0;
+static uint32_t started = 0;
+
+/*
+ * @brief   Records how long the routine took to start after it was spawned.
+ * @param   arg the spawn time
+ * @return  A void pointer.
+ */
+void *routine(void *arg)
+{
+    __atomic_fetch_add(&total, __sgMonoNanos() - (int64_t)(intptr_t)arg, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&started, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/*
+ * @brief   Measures the spawn-to-start latency of each mode, spawning routines one at a time from the main thread with a short pause in between, so every spawn finds the workers idle.
+ * @param   none
+ * @return  `0`.
+ */
+int main()
+{
+    const char *names[] = {"thread", "M:N", "coroutine", "pool"};
+
+    for (int mode = SG_MODE_THREAD; mode <= SG_MODE_POOL; ++mode)
+    {
+        sgConfig cfg = sgConfigDefault();
+        cfg.mode = (sgMode)mode;
+        cfg.idleTimeout = 100LL * SG_TIME_MS;
+        cfg.minWorkers = 2;
+        cfg.maxWorkers = 64;
+
+        sgRuntime *rt = sgRuntimeCreate(&cfg);
+        if (rt == NULL)
+            return 1;
+
+        total = 0;
+        started = 0;
+        for (int i = 0; i < SPAWNS; ++i)
+        {
+            segoOn(rt, routine, (void *)(intptr_t)__sgMonoNanos());
+            sgMomentSleep(20LL * SG_TIME_US);
+        }
+
+        while (__atomic_load_n(&started, __ATOMIC_ACQUIRE) < SPAWNS)
+            sgMomentSleep(SG_TIME_MS);
+
+        printf("%-9s: %.1f us spawn to start\n", names[mode], (double)total / SPAWNS / 1000.0);
+        sgRuntimeShutdown(rt, -1, NULL);
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef __SEGO_BLOCKING_H
+#define __SEGO_BLOCKING_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "enums.h"
+#include "scheduler.h"
+#include "park.h"
+
+    typedef struct
+    {
+        sgRoutine fn;
+        void *arg;
+        void *result;
+        __sgParker p;
+    } __sgBlockingCall;
+
+    /*
+     * @brief   The routine that runs a blocking call on the blocking pool and resumes the routine waiting for it.
+     * @param   a the call
+     * @return  A void pointer.
+     */
+    void *__sgBlockingRoutine(void *a)
+    {
+        __sgBlockingCall *c = (__sgBlockingCall *)a;
+        c->result = c->fn(c->arg);
+        __sgParkerSignal(&c->p, NULL);
+        return NULL;
+    }
+
+    /*
+     * @brief   Runs a function that may block in a system call, such as `read()`, `write()` or `fsync()`, without holding up the other routines of the caller's worker.
+     * @param   fn the function
+     * @param   arg the argument to be passed to the function
+     * @return  The return value of the function, or `NULL` if the function is a `NULL`.
+     * @note    Inside a coroutine, the function runs on the runtime's blocking pool while only the calling routine is suspended. On an `SG_MODE_MN` or `SG_MODE_POOL` worker, the function runs in place after the worker's queued routines are handed to a parked worker, or to a new one in `SG_MODE_POOL`. Elsewhere, it simply runs in place.
+     */
+    void *sgBlocking(sgRoutine fn, void *arg)
+    {
+        if (fn == NULL)
+            return NULL;
+
+        __sgTask *t = __sgSchedCurrentTask();
+        if (t != NULL)
+        {
+            __sgSched *b = __sgSchedBlockingPool(t->sched);
+            if (b != NULL)
+            {
+                __sgBlockingCall c = {.fn = fn, .arg = arg, .result = NULL};
+                __sgParkerInit(&c.p);
+                if (__sgSchedSubmit(b, __sgBlockingRoutine, &c) == SG_OK)
+                {
+                    while (__atomic_load_n(&c.p.state, __ATOMIC_ACQUIRE) != __SG_PARKER_SIGNALED)
+                        __sgParkerWait(&c.p, NULL, -1);
+                    return c.result;
+                }
+            }
+
+            return fn(arg);
+        }
+
+        __sgWorker *w = __sgSchedCurrentWorker();
+        if (w != NULL)
+            __sgSchedHandoff(w);
+
+        return fn(arg);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
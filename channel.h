@@ -12,130 +12,528 @@ extern "C"
 #include <unistd.h>
 #include "enums.h"
 #include "queue.h"
+#include "spsc.h"
+#include "mpmc.h"
+#include "park.h"
+#include "context.h"
+#include "numa.h"
+
+#define __SG_CHAN_RING_SPIN 64
 
     typedef struct
     {
         pthread_mutex_t lock;
         pthread_cond_t cond;
         sgQueue *queue;
-        int fd[2];
+        __sgWaitList waiters;
+        __sgWaitList senders;
+        sgChanPolicy policy;
+        uint8_t onNode;
+        __sgSpsc *spsc;
+        __sgMpmc *mpmc;
     } sgChan;
 
     /*
-     * @brief   Makes new channel.
+     * @brief   Initializes a channel in place.
+     * @param   ch the channel
      * @param   itemSize the item of the transported data in the channel
      * @param   bufferSize the channel's buffer size
-     * @return  The pointer to the channel (`sgChan`) instance.
+     * @param   node the NUMA node of the buffer, or `__SG_QUEUE_HEAP` for the heap
+     * @param   policy what a sender does while the buffer is full
+     * @return  `SG_ERR_PTHREAD` if a lock could not be set up. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
      */
-    sgChan *sgChanMake(size_t itemSize, size_t bufferSize)
+    sgReturnType __sgChanInit(sgChan *ch, size_t itemSize, size_t bufferSize, int node, sgChanPolicy policy)
     {
-        sgChan *ch = (sgChan *)malloc(sizeof(sgChan));
-        if (!ch)
-            return NULL;
-
         if (pthread_mutex_init(&ch->lock, NULL) != 0)
-        {
-            free(ch);
-            return NULL;
-        }
+            return SG_ERR_PTHREAD;
 
         if (pthread_cond_init(&ch->cond, NULL) != 0)
         {
             pthread_mutex_destroy(&ch->lock);
-            free(ch);
-            return NULL;
+            return SG_ERR_PTHREAD;
         }
 
-        ch->queue = sgQueueCreate(itemSize, bufferSize);
+        ch->queue = __sgQueueCreate(itemSize, bufferSize, node);
         if (!ch->queue)
         {
             pthread_mutex_destroy(&ch->lock);
             pthread_cond_destroy(&ch->cond);
+            return SG_ERR_ALLOC;
+        }
+
+        ch->waiters.head = NULL;
+        ch->waiters.tail = NULL;
+        ch->senders.head = NULL;
+        ch->senders.tail = NULL;
+        ch->policy = policy;
+        ch->onNode = 0x00;
+        ch->spsc = NULL;
+        ch->mpmc = NULL;
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Makes new channel with an overflow policy.
+     * @param   itemSize the item of the transported data in the channel
+     * @param   bufferSize the channel's buffer size
+     * @param   policy what a sender does while the buffer is full: `SG_CHAN_DROP_OLDEST` drops the earliest item, `SG_CHAN_DROP_NEWEST` drops the item being sent, `SG_CHAN_BLOCK` waits for a receiver to make room
+     * @return  The pointer to the channel (`sgChan`) instance, or `NULL` if failed.
+     * @note    With `SG_CHAN_BLOCK`, senders are throttled to the pace of the receivers. Use `sgChanInTimed()` to bound the wait.
+     */
+    sgChan *sgChanMakeWithPolicy(size_t itemSize, size_t bufferSize, sgChanPolicy policy)
+    {
+        if (policy > SG_CHAN_BLOCK)
+            return NULL;
+
+        sgChan *ch = (sgChan *)malloc(sizeof(sgChan));
+        if (!ch)
+            return NULL;
+
+        if (__sgChanInit(ch, itemSize, bufferSize, __SG_QUEUE_HEAP, policy) != SG_OK)
+        {
             free(ch);
             return NULL;
         }
 
-        if (pipe(ch->fd) == -1)
+        return ch;
+    }
+
+    /*
+     * @brief   Makes new channel.
+     * @param   itemSize the item of the transported data in the channel
+     * @param   bufferSize the channel's buffer size
+     * @return  The pointer to the channel (`sgChan`) instance.
+     * @note    While the buffer is full, sending drops the earliest item. Use `sgChanMakeWithPolicy()` to pick another policy.
+     */
+    sgChan *sgChanMake(size_t itemSize, size_t bufferSize)
+    {
+        return sgChanMakeWithPolicy(itemSize, bufferSize, SG_CHAN_DROP_OLDEST);
+    }
+
+    /*
+     * @brief   Makes new channel whose lock, wait list and buffer live in the memory of a NUMA node.
+     * @param   itemSize the item of the transported data in the channel
+     * @param   bufferSize the channel's buffer size
+     * @param   node the node, numbered from `0` to `sgNumaNodes() - 1`, or `SG_NUMA_LOCAL` for the caller's node
+     * @return  The pointer to the channel (`sgChan`) instance.
+     * @note    Pick the node of the routines that use the channel most, e.g. `sgNumaCurrentNode()` from a routine of a runtime with `SG_AFFINITY_NODE`.
+     */
+    sgChan *sgChanMakeOnNode(size_t itemSize, size_t bufferSize, int node)
+    {
+        sgChan *ch = (sgChan *)__sgNumaAlloc(sizeof(sgChan), node);
+        if (!ch)
+            return NULL;
+
+        if (__sgChanInit(ch, itemSize, bufferSize, node, SG_CHAN_DROP_OLDEST) != SG_OK)
         {
-            pthread_mutex_destroy(&ch->lock);
-            pthread_cond_destroy(&ch->cond);
-            sgQueueDestroy(ch->queue);
+            __sgNumaFree(ch, sizeof(sgChan));
+            return NULL;
+        }
+
+        ch->onNode = 0x01;
+        return ch;
+    }
+
+    /*
+     * @brief   Makes new channel backed by a lock-free ring.
+     * @param   spsc the SPSC ring, or `NULL`
+     * @param   mpmc the MPMC ring, or `NULL`
+     * @return  The pointer to the channel (`sgChan`) instance, or `NULL` if failed.
+     * @note    The ring is owned by the channel, and destroyed if failed.
+     */
+    sgChan *__sgChanRingMake(__sgSpsc *spsc, __sgMpmc *mpmc)
+    {
+        if (spsc == NULL && mpmc == NULL)
+            return NULL;
+
+        sgChan *ch = (sgChan *)malloc(sizeof(sgChan));
+        if (!ch || pthread_mutex_init(&ch->lock, NULL) != 0)
+        {
+            __sgSpscDestroy(spsc);
+            __sgMpmcDestroy(mpmc);
             free(ch);
             return NULL;
         }
 
+        ch->queue = NULL;
+        ch->waiters.head = NULL;
+        ch->waiters.tail = NULL;
+        ch->senders.head = NULL;
+        ch->senders.tail = NULL;
+        ch->policy = SG_CHAN_BLOCK;
+        ch->onNode = 0x00;
+        ch->spsc = spsc;
+        ch->mpmc = mpmc;
         return ch;
     }
 
     /*
-     * @brief   Pushes a value to the pipe
+     * @brief   Makes new channel for exactly one sending routine and one receiving routine, backed by a lock-free ring.
+     * @param   itemSize the item of the transported data in the channel
+     * @param   bufferSize the channel's buffer size, rounded up to a power of two
+     * @return  The pointer to the channel (`sgChan`) instance.
+     * @note    `sgChanIn()` and `sgChanOut()` only copy the item and move an index, and take the lock only when the other side is parked. The sender waits while the buffer is full instead of dropping the earliest item.
+     * @note    At most one routine may send and one may receive at a time, `sgSelect()` counting as receiving.
+     */
+    sgChan *sgChanMakeSPSC(size_t itemSize, size_t bufferSize)
+    {
+        return __sgChanRingMake(__sgSpscCreate(itemSize, bufferSize), NULL);
+    }
+
+    /*
+     * @brief   Makes new channel for any number of sending and receiving routines, backed by a lock-free ring.
+     * @param   itemSize the item of the transported data in the channel
+     * @param   bufferSize the channel's buffer size, rounded up to a power of two, at least 2
+     * @return  The pointer to the channel (`sgChan`) instance.
+     * @note    Senders and receivers claim slots with an atomic compare-and-swap on their own index, and take the lock only to park while the buffer is empty or full, or to wake a parked one. The sender waits while the buffer is full instead of dropping the earliest item.
+     */
+    sgChan *sgChanMakeMPMC(size_t itemSize, size_t bufferSize)
+    {
+        return __sgChanRingMake(NULL, __sgMpmcCreate(itemSize, bufferSize));
+    }
+
+    /*
+     * @brief   Suspends the calling coroutine, or blocks the calling thread, until the channel is woken. The caller must hold the channel lock, which is held again on return.
      * @param   ch the channel instance
-     * @return  None.
+     * @param   list the wait list, `waiters` for receivers or `senders` for senders
+     * @param   timeout the timeout, `-1` for infinite wait
+     * @return  `SG_TIMEOUT` if timeout. `SG_OK` if woken.
+     */
+    sgReturnType __sgChanPark(sgChan *ch, __sgWaitList *list, int64_t timeout)
+    {
+        __sgParker p;
+        __sgWaitLink link;
+
+        __sgParkerInit(&p);
+        __sgWaitListAdd(list, &link, &p, ch);
+        sgReturnType ret = __sgParkerWait(&p, &ch->lock, timeout);
+
+        pthread_mutex_lock(&ch->lock);
+        __sgWaitListRemove(list, &link);
+        return ret;
+    }
+
+    /*
+     * @brief   Checks whether a channel is backed by a lock-free ring, i.e. made with `sgChanMakeSPSC()` or `sgChanMakeMPMC()`.
+     * @param   ch the channel instance
+     * @return  `1` if it is. Otherwise, `0`.
+     */
+    uint8_t __sgChanIsRing(sgChan *ch)
+    {
+        return ch->spsc != NULL || ch->mpmc != NULL;
+    }
+
+    /*
+     * @brief   Pushes an item to the ring of a channel unless it is full.
+     * @param   ch the channel instance
+     * @param   data the item
+     * @return  `1` if pushed. Otherwise, `0`.
+     */
+    uint8_t __sgChanRingPush(sgChan *ch, void *data)
+    {
+        return (ch->spsc != NULL) ? __sgSpscPush(ch->spsc, data) : __sgMpmcPush(ch->mpmc, data);
+    }
+
+    /*
+     * @brief   Pops an item from the ring of a channel unless it is empty.
+     * @param   ch the channel instance
+     * @param   buf the buffer to hold the item
+     * @return  `1` if popped. Otherwise, `0`.
+     */
+    uint8_t __sgChanRingPop(sgChan *ch, void *buf)
+    {
+        return (ch->spsc != NULL) ? __sgSpscPop(ch->spsc, buf) : __sgMpmcPop(ch->mpmc, buf);
+    }
+
+    /*
+     * @brief   Checks whether the ring of a channel holds an item, or has room for one.
+     * @param   ch the channel instance
+     * @param   room `1` to check for room. `0` to check for an item
+     * @return  `1` if it does. Otherwise, `0`.
+     */
+    uint8_t __sgChanRingCan(sgChan *ch, uint8_t room)
+    {
+        if (ch->spsc != NULL)
+            return room ? __sgSpscRoom(ch->spsc) : __sgSpscReady(ch->spsc);
+
+        return room ? __sgMpmcRoom(ch->mpmc) : __sgMpmcReady(ch->mpmc);
+    }
+
+    /*
+     * @brief   Retrieves the number of parked senders or receivers of a ring channel.
+     * @param   ch the channel instance
+     * @param   room `1` for the senders. `0` for the receivers
+     * @return  The pointer to the counter.
      */
-    void __sgChanPipePush(sgChan *ch)
+    uint32_t *__sgChanRingParked(sgChan *ch, uint8_t room)
     {
-        static uint8_t val = 0xFF;
-        write(ch->fd[1], &val, 1);
+        if (ch->spsc != NULL)
+            return room ? &ch->spsc->txParked : &ch->spsc->rxParked;
+
+        return room ? &ch->mpmc->txParked : &ch->mpmc->rxParked;
     }
 
     /*
-     * @brief   Pops a value to the pipe
+     * @brief   Waits until the ring of a channel holds an item, or has room for one.
      * @param   ch the channel instance
+     * @param   room `1` to wait for room, as a sender. `0` to wait for an item, as a receiver
+     * @param   deadline the deadline, `-1` for infinite wait
+     * @param   ctx the context that ends the wait once raised, can be `NULL`
+     * @return  `SG_TIMEOUT` if timeout. `SG_CANCELED` if the context is raised. `SG_OK` if ok.
+     * @note    The waiter counts itself as parked before it checks the ring again, and the other side publishes its item or slot before it reads the count, so either the waiter sees the change or it gets woken.
+     */
+    sgReturnType __sgChanRingWait(sgChan *ch, uint8_t room, int64_t deadline, sgContext *ctx)
+    {
+        uint32_t *parked = __sgChanRingParked(ch, room);
+        __sgWaitList *list = room ? &ch->senders : &ch->waiters;
+        sgReturnType ret = SG_OK;
+
+        pthread_mutex_lock(&ch->lock);
+        __atomic_fetch_add(parked, 1, __ATOMIC_SEQ_CST);
+
+        while (!__sgChanRingCan(ch, room))
+        {
+            int64_t remaining = -1;
+            if (deadline >= 0)
+            {
+                remaining = deadline - __sgMonoNanos();
+                if (remaining <= 0)
+                {
+                    ret = SG_TIMEOUT;
+                    break;
+                }
+            }
+
+            __sgParker p;
+            __sgWaitLink ctxLink, chLink;
+            __sgParkerInit(&p);
+
+            if (ctx != NULL)
+            {
+                pthread_mutex_lock(&ctx->lock);
+                if (ctx->flag == SG_CTX_RAISED)
+                {
+                    pthread_mutex_unlock(&ctx->lock);
+                    ret = SG_CANCELED;
+                    break;
+                }
+                __sgWaitListAdd(&ctx->waiters, &ctxLink, &p, ctx);
+                pthread_mutex_unlock(&ctx->lock);
+            }
+
+            __sgWaitListAdd(list, &chLink, &p, ch);
+            __sgParkerWait(&p, &ch->lock, remaining);
+
+            if (ctx != NULL)
+            {
+                pthread_mutex_lock(&ctx->lock);
+                __sgWaitListRemove(&ctx->waiters, &ctxLink);
+                pthread_mutex_unlock(&ctx->lock);
+            }
+
+            pthread_mutex_lock(&ch->lock);
+            __sgWaitListRemove(list, &chLink);
+        }
+
+        __atomic_fetch_sub(parked, 1, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&ch->lock);
+        return ret;
+    }
+
+    /*
+     * @brief   Wakes a parked sender or receiver of a ring channel, if any, right after an item or a slot was published.
+     * @param   ch the channel instance
+     * @param   room `1` to wake a sender. `0` to wake a receiver
      * @return  None.
      */
-    void __sgChanPipePop(sgChan *ch)
+    void __sgChanRingNotify(sgChan *ch, uint8_t room)
     {
-        static uint8_t tmp;
-        read(ch->fd[0], &tmp, 1);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (!__atomic_load_n(__sgChanRingParked(ch, room), __ATOMIC_RELAXED))
+            return;
+
+        pthread_mutex_lock(&ch->lock);
+        __sgWaitListWakeOne(room ? &ch->senders : &ch->waiters, ch);
+        pthread_mutex_unlock(&ch->lock);
     }
 
     /*
-     * @brief   Sends data to the channel.
+     * @brief   Sends data to a ring channel, waiting while its buffer is full.
      * @param   ch the channel instance
      * @param   data the data
-     * @return  `SG_ERR_NULLPTR` if one argument is `NULL`. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     * @param   timeout the timeout, `-1` for infinite wait
+     * @return  `SG_TIMEOUT` if timeout. `SG_OK` if ok.
      */
-    sgReturnType sgChanIn(sgChan *ch, void *data)
+    sgReturnType __sgChanRingIn(sgChan *ch, void *data, int64_t timeout)
     {
-        if (ch == NULL || data == NULL)
-            return SG_ERR_NULLPTR;
+        int64_t deadline = (timeout >= 0) ? __sgMonoNanos() + timeout : -1;
+        uint32_t spins = 0;
+
+        while (!__sgChanRingPush(ch, data))
+        {
+            if (++spins < __SG_CHAN_RING_SPIN)
+                __sgCpuRelax();
+            else
+            {
+                sgReturnType ret = __sgChanRingWait(ch, 0x01, deadline, NULL);
+                if (ret != SG_OK)
+                    return ret;
+                spins = 0;
+            }
+        }
+
+        __sgChanRingNotify(ch, 0x00);
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Retrieves data from a ring channel, waiting while its buffer is empty.
+     * @param   ch the channel instance
+     * @param   buf the buffer to hold the data
+     * @param   timeout the timeout, `-1` for infinite wait
+     * @param   ctx the context that ends the wait once raised, winning over waiting data, can be `NULL`
+     * @return  `SG_TIMEOUT` if timeout. `SG_CANCELED` if the context is raised. `SG_OK` if ok.
+     */
+    sgReturnType __sgChanRingOut(sgChan *ch, void *buf, int64_t timeout, sgContext *ctx)
+    {
+        int64_t deadline = (timeout >= 0) ? __sgMonoNanos() + timeout : -1;
+        uint32_t spins = 0;
+
+        while (1)
+        {
+            if (ctx != NULL && sgContextGetFlag(ctx) == SG_CTX_RAISED)
+                return SG_CANCELED;
+
+            if (__sgChanRingPop(ch, buf))
+                break;
+
+            if (++spins < __SG_CHAN_RING_SPIN)
+                __sgCpuRelax();
+            else
+            {
+                sgReturnType ret = __sgChanRingWait(ch, 0x00, deadline, ctx);
+                if (ret != SG_OK)
+                    return ret;
+                spins = 0;
+            }
+        }
+
+        __sgChanRingNotify(ch, 0x01);
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Sends data to a locked channel, following its overflow policy while the buffer is full.
+     * @param   ch the channel instance
+     * @param   data the data
+     * @param   timeout the timeout of `SG_CHAN_BLOCK`, `-1` for infinite wait
+     * @return  `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_QUEUE_FULL` if an item was dropped. `SG_TIMEOUT` if timeout. `SG_OK` if ok.
+     */
+    sgReturnType __sgChanQueueIn(sgChan *ch, void *data, int64_t timeout)
+    {
+        int64_t deadline = (timeout >= 0) ? __sgMonoNanos() + timeout : -1;
 
         pthread_mutex_lock(&ch->lock);
 
+        while (ch->policy != SG_CHAN_DROP_OLDEST && ch->queue->waiting == ch->queue->bufferSize)
+        {
+            int64_t remaining = -1;
+            if (deadline >= 0)
+                remaining = deadline - __sgMonoNanos();
+
+            if (ch->policy == SG_CHAN_DROP_NEWEST || (deadline >= 0 && remaining <= 0))
+            {
+                pthread_mutex_unlock(&ch->lock);
+                return (ch->policy == SG_CHAN_DROP_NEWEST) ? SG_QUEUE_FULL : SG_TIMEOUT;
+            }
+
+            __sgChanPark(ch, &ch->senders, remaining);
+        }
+
         sgReturnType ret = sgQueueQueue(ch->queue, data);
-        if (ret == SG_OK)
+        if (ret == SG_OK || ret == SG_QUEUE_FULL)
         {
             pthread_cond_signal(&ch->cond);
-            __sgChanPipePush(ch);
+            __sgWaitListWakeOne(&ch->waiters, ch);
         }
-        else if (ret == SG_QUEUE_FULL)
-            pthread_cond_signal(&ch->cond);
 
         pthread_mutex_unlock(&ch->lock);
 
         return ret;
     }
 
+    /*
+     * @brief   Sends data to the channel.
+     * @param   ch the channel instance
+     * @param   data the data
+     * @return  `SG_ERR_NULLPTR` if one argument is `NULL`. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_QUEUE_FULL` if the buffer was full and the earliest item (`SG_CHAN_DROP_OLDEST`) or this one (`SG_CHAN_DROP_NEWEST`) was dropped. `SG_OK` if ok.
+     * @note    With `SG_CHAN_BLOCK`, this function is blocking while the buffer is full. Inside a coroutine, only the calling routine is suspended.
+     */
+    sgReturnType sgChanIn(sgChan *ch, void *data)
+    {
+        if (ch == NULL || data == NULL)
+            return SG_ERR_NULLPTR;
+
+        if (__sgChanIsRing(ch))
+            return __sgChanRingIn(ch, data, -1);
+
+        return __sgChanQueueIn(ch, data, -1);
+    }
+
+    /*
+     * @brief   Sends data to the channel with timeout.
+     * @param   ch the channel instance
+     * @param   data the data
+     * @param   timeout the duration until timeout
+     * @return  `SG_ERR_NULLPTR` if one argument is `NULL`. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_QUEUE_FULL` if an item was dropped. `SG_TIMEOUT` if timeout. `SG_OK` if ok.
+     * @note    Only waits on channels that block while full, i.e. made with `SG_CHAN_BLOCK`, `sgChanMakeSPSC()` or `sgChanMakeMPMC()`. Otherwise, it is the same as `sgChanIn()`.
+     * @note    Multiply the timeout with the desired time unit, e.g. 500L * `SG_TIME_MS` for 500ms timeout duration. Inside a coroutine, only the calling routine is suspended.
+     */
+    sgReturnType sgChanInTimed(sgChan *ch, void *data, long timeout)
+    {
+        if (ch == NULL || data == NULL)
+            return SG_ERR_NULLPTR;
+
+        if (timeout < 0)
+            timeout = 0;
+
+        if (__sgChanIsRing(ch))
+            return __sgChanRingIn(ch, data, timeout);
+
+        return __sgChanQueueIn(ch, data, timeout);
+    }
+
     /*
      * @brief   Retrieves data from the channel.
      * @param   ch the channel instance
      * @param   buf the buffer to hold the data
      * @return  `SG_ERR_NULLPTR` if one argument is `NULL`. `SG_OK` if ok.
-     * @note    This function is blocking.
+     * @note    This function is blocking. Inside a coroutine, only the calling routine is suspended.
      */
     sgReturnType sgChanOut(sgChan *ch, void *buf)
     {
         if (ch == NULL || buf == NULL)
             return SG_ERR_NULLPTR;
 
+        if (__sgChanIsRing(ch))
+            return __sgChanRingOut(ch, buf, -1, NULL);
+
         pthread_mutex_lock(&ch->lock);
 
         while (ch->queue->waiting == 0)
-            pthread_cond_wait(&ch->cond, &ch->lock);
+        {
+            if (__sgSchedCurrentTask() == NULL)
+                pthread_cond_wait(&ch->cond, &ch->lock);
+            else
+                __sgChanPark(ch, &ch->waiters, -1);
+        }
 
         sgReturnType ret = sgQueueDequeue(ch->queue, buf);
         if (ret == SG_OK)
-            __sgChanPipePop(ch);
+            __sgWaitListWakeOne(&ch->senders, ch);
+
+        if (ch->queue->waiting > 0)
+            __sgWaitListWakeOne(&ch->waiters, ch);
 
         pthread_mutex_unlock(&ch->lock);
 
@@ -149,15 +547,32 @@ extern "C"
      * @param   timeout the duration until timeout
      * @return  `SG_ERR_NULLPTR` if one argument is `NULL`. `SG_TIMEOUT` if timeout. `SG_OK` if ok.
      * @note    This function is blocking up until timeout. Multiply the timeout with the desired time unit, e.g. 500L * `SG_TIME_MS` for 500ms timeout duration.
+     * @note    Inside a coroutine, only the calling routine is suspended.
      */
     sgReturnType sgChanOutTimed(sgChan *ch, void *buf, long timeout)
     {
         if (ch == NULL || buf == NULL)
             return SG_ERR_NULLPTR;
 
+        if (__sgChanIsRing(ch))
+            return __sgChanRingOut(ch, buf, (timeout < 0) ? 0 : timeout, NULL);
+
         pthread_mutex_lock(&ch->lock);
 
-        if (ch->queue->waiting == 0)
+        if (ch->queue->waiting == 0 && __sgSchedCurrentTask() != NULL)
+        {
+            int64_t deadline = __sgMonoNanos() + timeout;
+            while (ch->queue->waiting == 0)
+            {
+                int64_t remaining = deadline - __sgMonoNanos();
+                if (remaining <= 0 || (__sgChanPark(ch, &ch->waiters, remaining) == SG_TIMEOUT && ch->queue->waiting == 0))
+                {
+                    pthread_mutex_unlock(&ch->lock);
+                    return SG_TIMEOUT;
+                }
+            }
+        }
+        else if (ch->queue->waiting == 0)
         {
             struct timespec ts;
             clock_gettime(CLOCK_REALTIME, &ts);
@@ -182,13 +597,127 @@ extern "C"
         }
         sgReturnType ret = sgQueueDequeue(ch->queue, buf);
         if (ret == SG_OK)
-            __sgChanPipePop(ch);
+            __sgWaitListWakeOne(&ch->senders, ch);
+
+        if (ch->queue->waiting > 0)
+            __sgWaitListWakeOne(&ch->waiters, ch);
+
+        pthread_mutex_unlock(&ch->lock);
+
+        return ret;
+    }
+
+    /*
+     * @brief   Retrieves data from the channel, unless a context is raised first.
+     * @param   ch the channel instance
+     * @param   buf the buffer to hold the data
+     * @param   ctx the context instance
+     * @return  `SG_ERR_NULLPTR` if one argument is `NULL`. `SG_CANCELED` if the context is raised. `SG_OK` if ok.
+     * @note    This function is blocking until data arrives or the context is raised, and a raised context wins over waiting data. Inside a coroutine, only the calling routine is suspended.
+     */
+    sgReturnType sgChanOutContext(sgChan *ch, void *buf, sgContext *ctx)
+    {
+        if (ch == NULL || buf == NULL || ctx == NULL)
+            return SG_ERR_NULLPTR;
+
+        if (__sgChanIsRing(ch))
+            return __sgChanRingOut(ch, buf, -1, ctx);
+
+        pthread_mutex_lock(&ch->lock);
+
+        while (1)
+        {
+            __sgParker p;
+            __sgWaitLink ctxLink, chLink;
+            __sgParkerInit(&p);
+
+            pthread_mutex_lock(&ctx->lock);
+            if (ctx->flag == SG_CTX_RAISED)
+            {
+                pthread_mutex_unlock(&ctx->lock);
+                pthread_mutex_unlock(&ch->lock);
+                return SG_CANCELED;
+            }
+
+            if (ch->queue->waiting > 0)
+            {
+                pthread_mutex_unlock(&ctx->lock);
+                break;
+            }
+
+            __sgWaitListAdd(&ctx->waiters, &ctxLink, &p, ctx);
+            pthread_mutex_unlock(&ctx->lock);
+
+            __sgWaitListAdd(&ch->waiters, &chLink, &p, ch);
+            __sgParkerWait(&p, &ch->lock, -1);
+
+            pthread_mutex_lock(&ctx->lock);
+            __sgWaitListRemove(&ctx->waiters, &ctxLink);
+            pthread_mutex_unlock(&ctx->lock);
+
+            pthread_mutex_lock(&ch->lock);
+            __sgWaitListRemove(&ch->waiters, &chLink);
+        }
+
+        sgReturnType ret = sgQueueDequeue(ch->queue, buf);
+        if (ret == SG_OK)
+            __sgWaitListWakeOne(&ch->senders, ch);
+
+        if (ch->queue->waiting > 0)
+            __sgWaitListWakeOne(&ch->waiters, ch);
 
         pthread_mutex_unlock(&ch->lock);
 
         return ret;
     }
 
+    /*
+     * @brief   Checks whether a channel holds data, for a selector about to park on it. The caller must hold the channel lock.
+     * @param   ch the channel instance
+     * @return  `1` if it does. Otherwise, `0`, in which case the selector must park on the channel's wait list and call `__sgChanSelectDisarm()` once woken.
+     * @note    On a ring channel, the selector counts itself as a parked receiver first, so a sender wakes it.
+     */
+    uint8_t __sgChanSelectArm(sgChan *ch)
+    {
+        if (!__sgChanIsRing(ch))
+            return ch->queue->waiting > 0;
+
+        uint32_t *parked = __sgChanRingParked(ch, 0x00);
+        __atomic_fetch_add(parked, 1, __ATOMIC_SEQ_CST);
+        if (!__sgChanRingCan(ch, 0x00))
+            return 0x00;
+
+        __atomic_fetch_sub(parked, 1, __ATOMIC_RELAXED);
+        return 0x01;
+    }
+
+    /*
+     * @brief   Drops what `__sgChanSelectArm()` counted on a channel. The caller must hold the channel lock.
+     * @param   ch the channel instance
+     * @return  None.
+     */
+    void __sgChanSelectDisarm(sgChan *ch)
+    {
+        if (__sgChanIsRing(ch))
+            __atomic_fetch_sub(__sgChanRingParked(ch, 0x00), 1, __ATOMIC_RELAXED);
+    }
+
+    /*
+     * @brief   Checks whether a channel holds data, without waiting.
+     * @param   ch the channel instance
+     * @return  `1` if it does. Otherwise, `0`.
+     */
+    uint8_t __sgChanReady(sgChan *ch)
+    {
+        if (__sgChanIsRing(ch))
+            return __sgChanRingCan(ch, 0x00);
+
+        pthread_mutex_lock(&ch->lock);
+        uint8_t ready = ch->queue->waiting > 0;
+        pthread_mutex_unlock(&ch->lock);
+        return ready;
+    }
+
     /*
      * @brief   Destroys the channel instance.
      * @param   ch the channel instance
@@ -199,12 +728,23 @@ extern "C"
         if (ch == NULL)
             return;
 
+        if (__sgChanIsRing(ch))
+        {
+            __sgSpscDestroy(ch->spsc);
+            __sgMpmcDestroy(ch->mpmc);
+            pthread_mutex_destroy(&ch->lock);
+            free(ch);
+            return;
+        }
+
         sgQueueDestroy(ch->queue);
         pthread_mutex_destroy(&ch->lock);
         pthread_cond_destroy(&ch->cond);
-        close(ch->fd[0]);
-        close(ch->fd[1]);
-        free(ch);
+
+        if (ch->onNode)
+            __sgNumaFree(ch, sizeof(sgChan));
+        else
+            free(ch);
     }
 
 #ifdef __cplusplus
@@ -0,0 +1,89 @@
+#ifndef __SEGO_CONFIG_H
+#define __SEGO_CONFIG_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "enums.h"
+#include "numa.h"
+
+    typedef struct
+    {
+        sgMode mode;
+        uint32_t workers;
+        size_t stackSize;
+        uint32_t minWorkers;
+        uint32_t maxWorkers;
+        int64_t idleTimeout;
+        sgAffinity affinity;
+        const sgCpuSet *cpuSet;
+        int64_t agingTimeout;
+        uint64_t maxRoutines;
+        uint64_t maxQueued;
+        uint8_t runNext;
+        int64_t timeSlice;
+    } sgConfig;
+
+    typedef struct
+    {
+        sgPriority priority;
+        int64_t deadline;
+        size_t stackSize;
+    } sgAttr;
+
+    /*
+     * @brief   Retrieves the default sego configuration.
+     * @param   none
+     * @return  The configuration: thread-per-routine mode, one worker per online CPU for the M:N modes, default stack size (the system default for routine threads, `SG_CO_STACK_SIZE` for coroutines), a pool of 1 to 16 workers per online CPU with a 10s idle timeout, no CPU pinning, 50ms before a waiting lower-priority routine is run ahead of higher ones, no limit on concurrent routines, run-next slot on, 10ms time slice.
+     * @note    Multiply `idleTimeout`, `agingTimeout` and `timeSlice` with the desired time unit, e.g. 500L * `SG_TIME_MS` for 500ms.
+     * @note    With `SG_AFFINITY_NODE`, each worker (or routine thread) is restricted to the CPUs of one NUMA node, and spawns from outside the workers are queued on the spawner's node. With `SG_AFFINITY_CPU`, each is pinned to a single CPU. `cpuSet` limits the CPUs used, `NULL` means the process affinity mask.
+     * @note    `maxRoutines` caps how many routines may run at once, `0` for no limit. Spawns beyond it wait in an admission queue of at most `maxQueued` entries (`0` for no limit) and are started as running routines return. Spawns that find the queue full are rejected.
+     * @note    `runNext` applies to `SG_MODE_COROUTINE`: a routine woken by another one, e.g. the receiver of `sgChanIn()`, runs next on the waker's worker instead of being queued behind other routines or stolen by another worker, so the message it picks up is still in that CPU's cache.
+     * @note    `timeSlice` applies to `SG_MODE_COROUTINE`: a routine running longer than it is asked to yield at its next `sgCheckpoint()`, and idle workers take over the rest of its worker's queue. `0` means 10ms, `-1` turns the monitor off.
+     */
+    sgConfig sgConfigDefault()
+    {
+        sgConfig cfg = {
+            .mode = SG_MODE_THREAD,
+            .workers = 0,
+            .stackSize = 0,
+            .minWorkers = 1,
+            .maxWorkers = 0,
+            .idleTimeout = 10LL * SG_TIME_S,
+            .affinity = SG_AFFINITY_NONE,
+            .cpuSet = NULL,
+            .agingTimeout = 50LL * SG_TIME_MS,
+            .maxRoutines = 0,
+            .maxQueued = 0,
+            .runNext = 0x01,
+            .timeSlice = 10LL * SG_TIME_MS};
+
+        return cfg;
+    }
+
+    /*
+     * @brief   Retrieves the default sego routine attributes.
+     * @param   none
+     * @return  The attributes: `SG_PRIO_NORMAL` priority, no deadline, the runtime's stack size.
+     * @note    `deadline` is relative to the spawn, `-1` for none. Multiply it with the desired time unit, e.g. 5L * `SG_TIME_MS` for 5ms.
+     * @note    `stackSize` sets the stack of the routine thread in `SG_MODE_THREAD` and of the routine coroutine in `SG_MODE_COROUTINE`, `0` for the runtime's `stackSize`. Stacks are rounded up to a power-of-two size class and recycled through a shared pool.
+     */
+    sgAttr sgAttrDefault()
+    {
+        sgAttr attr = {
+            .priority = SG_PRIO_NORMAL,
+            .deadline = -1,
+            .stackSize = 0};
+
+        return attr;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
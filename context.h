@@ -13,12 +13,13 @@ extern "C"
 #include <signal.h>
 #include <time.h>
 #include "enums.h"
+#include "park.h"
 
     typedef struct
     {
         pthread_mutex_t lock;
         sgContextFlag flag;
-        int fd[2];
+        __sgWaitList waiters;
     } sgContext;
 
     /*
@@ -38,39 +39,12 @@ extern "C"
             return NULL;
         }
 
-        if (pipe(ctx->fd) == -1)
-        {
-            pthread_mutex_destroy(&ctx->lock);
-            free(ctx);
-            return NULL;
-        }
-
         ctx->flag = SG_CTX_LOWERED;
+        ctx->waiters.head = NULL;
+        ctx->waiters.tail = NULL;
         return ctx;
     }
 
-    /*
-     * @brief   Pushes a value to the pipe
-     * @param   ctx the context instance
-     * @return  None.
-     */
-    void __sgContextPipePush(sgContext *ctx)
-    {
-        static uint8_t val = 0xFF;
-        write(ctx->fd[1], &val, 1);
-    }
-
-    /*
-     * @brief   Pops a value to the pipe
-     * @param   ctx the context instance
-     * @return  None.
-     */
-    void __sgContextPipePop(sgContext *ctx)
-    {
-        static uint8_t tmp;
-        read(ctx->fd[0], &tmp, 1);
-    }
-
     /*
      * @brief   Raises the context flag.
      * @param   ctx the context instance
@@ -85,7 +59,7 @@ extern "C"
         if (ctx->flag != SG_CTX_RAISED)
         {
             ctx->flag = SG_CTX_RAISED;
-            __sgContextPipePush(ctx);
+            __sgWaitListWakeAll(&ctx->waiters, ctx);
         }
         pthread_mutex_unlock(&ctx->lock);
 
@@ -103,11 +77,7 @@ extern "C"
             return SG_ERR_NULLPTR;
 
         pthread_mutex_lock(&ctx->lock);
-        if (ctx->flag != SG_CTX_LOWERED)
-        {
-            ctx->flag = SG_CTX_LOWERED;
-            __sgContextPipePop(ctx);
-        }
+        ctx->flag = SG_CTX_LOWERED;
         pthread_mutex_unlock(&ctx->lock);
 
         return SG_OK;
@@ -0,0 +1,179 @@
+#ifndef __SEGO_COROUTINE_H
+#define __SEGO_COROUTINE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+#include "enums.h"
+#include "stack.h"
+
+#define SG_CO_STACK_SIZE (256UL * 1024UL)
+
+    typedef void (*__sgCoEntry)(void *);
+
+    typedef struct
+    {
+#if defined(__x86_64__)
+        void *sp;
+#else
+        ucontext_t uc;
+#endif
+    } __sgCoCtx;
+
+    typedef struct
+    {
+        __sgCoCtx ctx;
+        void *stack;
+        size_t stackSize;
+        __sgCoEntry entry;
+        void *arg;
+    } __sgCo;
+
+#if defined(__x86_64__)
+    void __sgCoSwitchAsm(void **save, void *load);
+    void __sgCoTrampolineAsm();
+
+    __asm__(
+        ".text\n"
+        ".globl __sgCoSwitchAsm\n"
+        ".type __sgCoSwitchAsm,@function\n"
+        "__sgCoSwitchAsm:\n"
+        "    pushq %rbp\n"
+        "    pushq %rbx\n"
+        "    pushq %r12\n"
+        "    pushq %r13\n"
+        "    pushq %r14\n"
+        "    pushq %r15\n"
+        "    subq $8, %rsp\n"
+        "    stmxcsr (%rsp)\n"
+        "    fnstcw 4(%rsp)\n"
+        "    movq %rsp, (%rdi)\n"
+        "    movq %rsi, %rsp\n"
+        "    ldmxcsr (%rsp)\n"
+        "    fldcw 4(%rsp)\n"
+        "    addq $8, %rsp\n"
+        "    popq %r15\n"
+        "    popq %r14\n"
+        "    popq %r13\n"
+        "    popq %r12\n"
+        "    popq %rbx\n"
+        "    popq %rbp\n"
+        "    ret\n"
+        ".size __sgCoSwitchAsm,.-__sgCoSwitchAsm\n"
+        ".globl __sgCoTrampolineAsm\n"
+        ".type __sgCoTrampolineAsm,@function\n"
+        "__sgCoTrampolineAsm:\n"
+        "    movq %r12, %rdi\n"
+        "    callq *%r13\n"
+        "    ud2\n"
+        ".size __sgCoTrampolineAsm,.-__sgCoTrampolineAsm\n");
+#else
+    /*
+     * @brief   Reassembles the coroutine pointer split by `makecontext()` and enters it.
+     * @param   hi the upper half of the coroutine pointer
+     * @param   lo the lower half of the coroutine pointer
+     * @return  None.
+     */
+    void __sgCoUcEntry(uint32_t hi, uint32_t lo)
+    {
+        __sgCo *co = (__sgCo *)(((uintptr_t)hi << 32) | (uintptr_t)lo);
+        co->entry(co->arg);
+        abort();
+    }
+#endif
+
+    /*
+     * @brief   Creates a coroutine on a guard-paged stack from the stack pool. It starts running at the first switch to it.
+     * @param   stackSize the usable stack size, `0` for `SG_CO_STACK_SIZE`
+     * @param   entry the entry function, which must never return
+     * @param   arg the argument to be passed to the entry function
+     * @return  The pointer to the coroutine, or `NULL` if failed.
+     */
+    __sgCo *__sgCoCreate(size_t stackSize, __sgCoEntry entry, void *arg)
+    {
+        __sgCo *co = (__sgCo *)malloc(sizeof(__sgCo));
+        if (!co)
+            return NULL;
+
+        co->stack = __sgStackAcquire((stackSize == 0) ? SG_CO_STACK_SIZE : stackSize, &co->stackSize);
+        if (!co->stack)
+        {
+            free(co);
+            return NULL;
+        }
+
+        co->entry = entry;
+        co->arg = arg;
+
+#if defined(__x86_64__)
+        uintptr_t top = ((uintptr_t)co->stack + co->stackSize) & ~(uintptr_t)15;
+        uint64_t *sp = (uint64_t *)(top - 80);
+        sp[0] = 0x037F00001F80ULL;
+        sp[1] = 0;
+        sp[2] = 0;
+        sp[3] = (uint64_t)(uintptr_t)entry;
+        sp[4] = (uint64_t)(uintptr_t)arg;
+        sp[5] = 0;
+        sp[6] = 0;
+        sp[7] = (uint64_t)(uintptr_t)__sgCoTrampolineAsm;
+        co->ctx.sp = sp;
+#else
+        if (getcontext(&co->ctx.uc) != 0)
+        {
+            __sgStackRelease(co->stack, co->stackSize);
+            free(co);
+            return NULL;
+        }
+        co->ctx.uc.uc_stack.ss_sp = co->stack;
+        co->ctx.uc.uc_stack.ss_size = co->stackSize;
+        co->ctx.uc.uc_link = NULL;
+        makecontext(&co->ctx.uc, (void (*)(void))__sgCoUcEntry, 2, (uint32_t)((uintptr_t)co >> 32), (uint32_t)(uintptr_t)co);
+#endif
+
+        return co;
+    }
+
+    /*
+     * @brief   Saves the current execution context and resumes another one.
+     * @param   from holds the current context
+     * @param   to the context to resume
+     * @return  None.
+     */
+    void __sgCoSwitch(__sgCoCtx *from, __sgCoCtx *to)
+    {
+#if defined(__x86_64__)
+        __sgCoSwitchAsm(&from->sp, to->sp);
+#else
+        swapcontext(&from->uc, &to->uc);
+#endif
+    }
+
+    /*
+     * @brief   Destroys the coroutine and returns its stack to the pool.
+     * @param   co the coroutine
+     * @return  None.
+     * @note    The coroutine must not be running.
+     */
+    void __sgCoDestroy(__sgCo *co)
+    {
+        if (co == NULL)
+            return;
+
+        __sgStackRelease(co->stack, co->stackSize);
+        free(co);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -15,7 +15,9 @@ extern "C"
         SG_ERR_NULLPTR,
         SG_ERR_ALLOC,
         SG_ERR_PTHREAD,
-        SG_ERR_INVALID
+        SG_ERR_INVALID,
+        SG_CANCELED,
+        SG_REJECTED
     } sgReturnType;
 
     typedef enum
@@ -33,6 +35,35 @@ extern "C"
         SG_TIME_S = 1000000000LL
     } sgTimeUnit;
 
+    typedef enum
+    {
+        SG_MODE_THREAD,
+        SG_MODE_MN,
+        SG_MODE_COROUTINE,
+        SG_MODE_POOL
+    } sgMode;
+
+    typedef enum
+    {
+        SG_AFFINITY_NONE,
+        SG_AFFINITY_NODE,
+        SG_AFFINITY_CPU
+    } sgAffinity;
+
+    typedef enum
+    {
+        SG_PRIO_REALTIME,
+        SG_PRIO_NORMAL,
+        SG_PRIO_BACKGROUND
+    } sgPriority;
+
+    typedef enum
+    {
+        SG_CHAN_DROP_OLDEST,
+        SG_CHAN_DROP_NEWEST,
+        SG_CHAN_BLOCK
+    } sgChanPolicy;
+
 #ifdef __cplusplus
 }
 #endif
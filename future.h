@@ -0,0 +1,370 @@
+#ifndef __SEGO_FUTURE_H
+#define __SEGO_FUTURE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "enums.h"
+#include "sync.h"
+#include "scheduler.h"
+#include "park.h"
+
+    typedef void *(*sgFutureFn)(void *value, void *arg);
+
+    typedef enum
+    {
+        __SG_FUTURE_PENDING,
+        __SG_FUTURE_READY
+    } __sgFutureState;
+
+    typedef struct sgFuture
+    {
+        uint32_t state;
+        uint32_t refs;
+        void *value;
+        pthread_mutex_t lock;
+        __sgWaitList waiters;
+        struct sgFuture *conts;
+        struct sgFuture *next;
+        void *rt;
+        sgRoutine fn;
+        sgFutureFn then;
+        void *arg;
+        void *input;
+    } sgFuture;
+
+    /*
+     * @brief   Creates a pending future with two references, one for its owner and one for whoever completes it.
+     * @param   rt the runtime continuations are scheduled on
+     * @return  The pointer to the future (`sgFuture`) instance, or `NULL` if failed.
+     */
+    sgFuture *__sgFutureCreate(void *rt)
+    {
+        sgFuture *f = (sgFuture *)malloc(sizeof(sgFuture));
+        if (!f)
+            return NULL;
+
+        if (pthread_mutex_init(&f->lock, NULL) != 0)
+        {
+            free(f);
+            return NULL;
+        }
+
+        f->state = __SG_FUTURE_PENDING;
+        f->refs = 2;
+        f->value = NULL;
+        f->waiters.head = NULL;
+        f->waiters.tail = NULL;
+        f->conts = NULL;
+        f->next = NULL;
+        f->rt = rt;
+        f->fn = NULL;
+        f->then = NULL;
+        f->arg = NULL;
+        f->input = NULL;
+        return f;
+    }
+
+    /*
+     * @brief   Drops a reference to a future, and frees it with the last one.
+     * @param   f the future
+     * @return  None.
+     */
+    void __sgFutureRelease(sgFuture *f)
+    {
+        if (__atomic_sub_fetch(&f->refs, 1, __ATOMIC_ACQ_REL) != 0)
+            return;
+
+        pthread_mutex_destroy(&f->lock);
+        free(f);
+    }
+
+    /*
+     * @brief   Completes a future with a value, wakes its waiters and runs its continuations, and theirs, on the calling thread.
+     * @param   f the future, whose completion reference is dropped
+     * @param   value the value
+     * @return  None.
+     */
+    void __sgFutureComplete(sgFuture *f, void *value)
+    {
+        sgFuture *todo = NULL;
+
+        while (f != NULL)
+        {
+            pthread_mutex_lock(&f->lock);
+            f->value = value;
+            __atomic_store_n(&f->state, __SG_FUTURE_READY, __ATOMIC_RELEASE);
+            __sgWaitListWakeAll(&f->waiters, f);
+            sgFuture *c = f->conts;
+            f->conts = NULL;
+            pthread_mutex_unlock(&f->lock);
+
+            while (c != NULL)
+            {
+                sgFuture *next = c->next;
+                c->input = value;
+                c->next = todo;
+                todo = c;
+                c = next;
+            }
+
+            __sgFutureRelease(f);
+
+            f = todo;
+            if (f != NULL)
+            {
+                todo = f->next;
+                value = f->then(f->input, f->arg);
+            }
+        }
+    }
+
+    /*
+     * @brief   Registers a continuation future to be completed right after a future.
+     * @param   f the future
+     * @param   g the continuation future
+     * @return  `1` if it was registered. `0` if the future is already completed, in which case the continuation's input is set to its value.
+     */
+    uint8_t __sgFutureChain(sgFuture *f, sgFuture *g)
+    {
+        uint8_t chained = 0x00;
+
+        pthread_mutex_lock(&f->lock);
+        if (__atomic_load_n(&f->state, __ATOMIC_ACQUIRE) == __SG_FUTURE_PENDING)
+        {
+            g->next = f->conts;
+            f->conts = g;
+            chained = 0x01;
+        }
+        else
+            g->input = f->value;
+        pthread_mutex_unlock(&f->lock);
+
+        return chained;
+    }
+
+    /*
+     * @brief   Checks whether a future is completed, without blocking.
+     * @param   f the future instance
+     * @return  `1` if it is. Otherwise, `0`.
+     */
+    uint8_t sgFutureReady(sgFuture *f)
+    {
+        if (f == NULL)
+            return 0x00;
+
+        return __atomic_load_n(&f->state, __ATOMIC_ACQUIRE) == __SG_FUTURE_READY;
+    }
+
+    /*
+     * @brief   Waits until one of several futures is completed, with timeout.
+     * @param   fs the future instances
+     * @param   n the number of futures
+     * @param   index holds the index of a completed future, can be `NULL`
+     * @param   timeout the timeout, `-1` for infinite wait
+     * @return  `SG_ERR_NULLPTR` if a future is a `NULL`. `SG_ERR_INVALID` if there is no future. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_TIMEOUT` if timeout. `SG_OK` if ok.
+     * @note    Inside a coroutine, this suspends only the calling routine.
+     * @note    Multiply the timeout with the desired time unit, e.g. 500L * `SG_TIME_MS` for 500ms timeout duration.
+     */
+    sgReturnType sgFutureWaitAnyTimed(sgFuture *const *fs, size_t n, size_t *index, int64_t timeout)
+    {
+        if (fs == NULL)
+            return SG_ERR_NULLPTR;
+
+        if (n == 0)
+            return SG_ERR_INVALID;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (fs[i] == NULL)
+                return SG_ERR_NULLPTR;
+
+            if (sgFutureReady(fs[i]))
+            {
+                if (index != NULL)
+                    *index = i;
+                return SG_OK;
+            }
+        }
+
+        if (timeout == 0)
+            return SG_TIMEOUT;
+
+        __sgWaitLink *links = (__sgWaitLink *)malloc(sizeof(__sgWaitLink) * n);
+        if (!links)
+            return SG_ERR_ALLOC;
+
+        __sgParker p;
+        __sgParkerInit(&p);
+
+        size_t reg = 0, hit = n;
+        for (; reg < n && hit == n; ++reg)
+        {
+            pthread_mutex_lock(&fs[reg]->lock);
+            if (__atomic_load_n(&fs[reg]->state, __ATOMIC_ACQUIRE) == __SG_FUTURE_READY)
+                hit = reg;
+            else
+                __sgWaitListAdd(&fs[reg]->waiters, &links[reg], &p, fs[reg]);
+            pthread_mutex_unlock(&fs[reg]->lock);
+        }
+
+        sgReturnType ret = SG_OK;
+        if (hit == n)
+        {
+            ret = __sgParkerWait(&p, NULL, timeout);
+            for (size_t i = 0; ret == SG_OK && i < n; ++i)
+                if (fs[i] == (sgFuture *)p.sel)
+                    hit = i;
+        }
+        else
+            reg -= 1;
+
+        for (size_t i = 0; i < reg; ++i)
+        {
+            pthread_mutex_lock(&fs[i]->lock);
+            __sgWaitListRemove(&fs[i]->waiters, &links[i]);
+            pthread_mutex_unlock(&fs[i]->lock);
+        }
+
+        free(links);
+        if (ret == SG_OK && index != NULL)
+            *index = hit;
+        return ret;
+    }
+
+    /*
+     * @brief   Waits until one of several futures is completed.
+     * @param   fs the future instances
+     * @param   n the number of futures
+     * @param   index holds the index of a completed future, can be `NULL`
+     * @return  `SG_ERR_NULLPTR` if a future is a `NULL`. `SG_ERR_INVALID` if there is no future. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     * @note    Inside a coroutine, this suspends only the calling routine.
+     */
+    sgReturnType sgFutureWaitAny(sgFuture *const *fs, size_t n, size_t *index)
+    {
+        return sgFutureWaitAnyTimed(fs, n, index, -1);
+    }
+
+    /*
+     * @brief   Waits until a future is completed, with timeout.
+     * @param   f the future instance
+     * @param   value holds the value of the future, can be `NULL`
+     * @param   timeout the timeout, `-1` for infinite wait
+     * @return  `SG_ERR_NULLPTR` if the future is a `NULL`. `SG_TIMEOUT` if timeout. `SG_OK` if ok.
+     * @note    A completed future is seen without taking any lock. Inside a coroutine, this suspends only the calling routine.
+     * @note    Multiply the timeout with the desired time unit, e.g. 500L * `SG_TIME_MS` for 500ms timeout duration.
+     */
+    sgReturnType sgFutureWaitTimed(sgFuture *f, void **value, int64_t timeout)
+    {
+        if (f == NULL)
+            return SG_ERR_NULLPTR;
+
+        if (!sgFutureReady(f))
+        {
+            __sgParker p;
+            __sgWaitLink link;
+            __sgParkerInit(&p);
+
+            pthread_mutex_lock(&f->lock);
+            if (__atomic_load_n(&f->state, __ATOMIC_ACQUIRE) == __SG_FUTURE_READY)
+            {
+                pthread_mutex_unlock(&f->lock);
+            }
+            else
+            {
+                __sgWaitListAdd(&f->waiters, &link, &p, f);
+                sgReturnType ret = __sgParkerWait(&p, &f->lock, timeout);
+
+                pthread_mutex_lock(&f->lock);
+                __sgWaitListRemove(&f->waiters, &link);
+                pthread_mutex_unlock(&f->lock);
+
+                if (ret != SG_OK)
+                    return ret;
+            }
+        }
+
+        if (value != NULL)
+            *value = f->value;
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Waits until a future is completed.
+     * @param   f the future instance
+     * @param   value holds the value of the future, can be `NULL`
+     * @return  `SG_ERR_NULLPTR` if the future is a `NULL`. `SG_OK` if ok.
+     * @note    Inside a coroutine, this suspends only the calling routine.
+     */
+    sgReturnType sgFutureWait(sgFuture *f, void **value)
+    {
+        return sgFutureWaitTimed(f, value, -1);
+    }
+
+    /*
+     * @brief   Waits until every one of several futures is completed, with timeout.
+     * @param   fs the future instances
+     * @param   n the number of futures
+     * @param   timeout the timeout for the whole wait, `-1` for infinite wait
+     * @return  `SG_ERR_NULLPTR` if a future is a `NULL`. `SG_TIMEOUT` if timeout. `SG_OK` if ok.
+     * @note    Inside a coroutine, this suspends only the calling routine.
+     * @note    Multiply the timeout with the desired time unit, e.g. 500L * `SG_TIME_MS` for 500ms timeout duration.
+     */
+    sgReturnType sgFutureWaitAllTimed(sgFuture *const *fs, size_t n, int64_t timeout)
+    {
+        if (fs == NULL && n > 0)
+            return SG_ERR_NULLPTR;
+
+        int64_t deadline = (timeout >= 0) ? __sgMonoNanos() + timeout : -1;
+        for (size_t i = 0; i < n; ++i)
+        {
+            int64_t remaining = -1;
+            if (deadline >= 0)
+            {
+                remaining = deadline - __sgMonoNanos();
+                if (remaining < 0)
+                    remaining = 0;
+            }
+
+            sgReturnType ret = sgFutureWaitTimed(fs[i], NULL, remaining);
+            if (ret != SG_OK)
+                return ret;
+        }
+
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Waits until every one of several futures is completed.
+     * @param   fs the future instances
+     * @param   n the number of futures
+     * @return  `SG_ERR_NULLPTR` if a future is a `NULL`. `SG_OK` if ok.
+     * @note    Inside a coroutine, this suspends only the calling routine.
+     */
+    sgReturnType sgFutureWaitAll(sgFuture *const *fs, size_t n)
+    {
+        return sgFutureWaitAllTimed(fs, n, -1);
+    }
+
+    /*
+     * @brief   Releases a future. Its routine and continuations still run, and the memory goes away once they are done with it.
+     * @param   f the future instance
+     * @return  None.
+     * @note    Every future from `segoFuture()` or `sgFutureThen()` must be destroyed exactly once, and not be waited on afterwards.
+     */
+    void sgFutureDestroy(sgFuture *f)
+    {
+        if (f != NULL)
+            __sgFutureRelease(f);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
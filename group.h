@@ -0,0 +1,153 @@
+#ifndef __SEGO_GROUP_H
+#define __SEGO_GROUP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "enums.h"
+#include "context.h"
+#include "waitgroup.h"
+
+    typedef void *(*sgGroupFn)(sgContext *ctx, void *arg);
+
+    typedef struct
+    {
+        void *rt;
+        sgContext *ctx;
+        sgWaitGroup wg;
+        uint32_t failed;
+        void *err;
+    } sgGroup;
+
+    typedef struct
+    {
+        sgGroup *g;
+        sgGroupFn fn;
+        void *arg;
+    } __sgGroupChild;
+
+    /*
+     * @brief   Creates a task group with its own context.
+     * @param   rt the runtime its children are started on
+     * @return  The pointer to the group (`sgGroup`) instance, or `NULL` if failed.
+     */
+    sgGroup *__sgGroupCreate(void *rt)
+    {
+        sgGroup *g = (sgGroup *)malloc(sizeof(sgGroup));
+        if (!g)
+            return NULL;
+
+        g->ctx = sgContextCreate();
+        if (g->ctx == NULL)
+        {
+            free(g);
+            return NULL;
+        }
+
+        if (__sgWaitGroupInit(&g->wg) != SG_OK)
+        {
+            sgContextDestroy(g->ctx);
+            free(g);
+            return NULL;
+        }
+
+        g->rt = rt;
+        g->failed = 0;
+        g->err = NULL;
+        return g;
+    }
+
+    /*
+     * @brief   The routine of a group child. A non-`NULL` result is recorded as the group error if it is the first one, and cancels the group.
+     * @param   a the child
+     * @return  A void pointer.
+     */
+    void *__sgGroupChildRoutine(void *a)
+    {
+        __sgGroupChild *c = (__sgGroupChild *)a;
+        sgGroup *g = c->g;
+
+        void *err = c->fn(g->ctx, c->arg);
+        free(c);
+
+        uint32_t expected = 0;
+        if (err != NULL && __atomic_compare_exchange_n(&g->failed, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            g->err = err;
+            sgContextRaise(g->ctx);
+        }
+
+        sgWaitGroupDone(&g->wg);
+        return NULL;
+    }
+
+    /*
+     * @brief   Retrieves the context of a task group, raised once the group is canceled.
+     * @param   g the group instance
+     * @return  The pointer to the context (`sgContext`), or `NULL` if the group is a `NULL`.
+     * @note    Children get it as their first argument. Pass it to `sgChanOutContext()` or `sgSelectWithContext()` so a blocked child returns as soon as the group is canceled.
+     */
+    sgContext *sgGroupContext(sgGroup *g)
+    {
+        return (g == NULL) ? NULL : g->ctx;
+    }
+
+    /*
+     * @brief   Cancels a task group by raising its context.
+     * @param   g the group instance
+     * @return  `SG_ERR_NULLPTR` if the group is a `NULL`. `SG_OK` if ok.
+     */
+    sgReturnType sgGroupCancel(sgGroup *g)
+    {
+        if (g == NULL)
+            return SG_ERR_NULLPTR;
+
+        return sgContextRaise(g->ctx);
+    }
+
+    /*
+     * @brief   Waits until every child of a task group has returned.
+     * @param   g the group instance
+     * @param   err holds the first non-`NULL` result of a child, or `NULL` if none failed, can be `NULL`
+     * @return  `SG_ERR_NULLPTR` if the group is a `NULL`. `SG_CANCELED` if a child failed. `SG_OK` if ok.
+     * @note    Inside a coroutine, this suspends only the calling routine.
+     */
+    sgReturnType sgGroupWait(sgGroup *g, void **err)
+    {
+        if (g == NULL)
+            return SG_ERR_NULLPTR;
+
+        sgWaitGroupWait(&g->wg);
+
+        uint8_t failed = __atomic_load_n(&g->failed, __ATOMIC_ACQUIRE) != 0;
+        if (err != NULL)
+            *err = failed ? g->err : NULL;
+
+        return failed ? SG_CANCELED : SG_OK;
+    }
+
+    /*
+     * @brief   Destroys a task group and its context.
+     * @param   g the group instance
+     * @return  None.
+     * @note    Call `sgGroupWait()` first, so no child still uses the group.
+     */
+    void sgGroupDestroy(sgGroup *g)
+    {
+        if (g == NULL)
+            return;
+
+        __sgWaitGroupDeinit(&g->wg);
+        sgContextDestroy(g->ctx);
+        free(g);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
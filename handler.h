@@ -7,95 +7,251 @@ extern "C"
 #endif
 
 #include <pthread.h>
-#include "uthash.h"
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include "enums.h"
 #include "channel.h"
 #include "context.h"
 #include "select.h"
+#include "config.h"
+#include "scheduler.h"
+#include "mpsc.h"
+#include "slab.h"
+#include "waitgroup.h"
+#include "numa.h"
+#include "stack.h"
+#include "arena.h"
+#include "admit.h"
 
 #include <stdio.h>
 
-    typedef void *(*sgRoutine)(void *);
+#define SG_THREAD_STACK_MIN (64UL * 1024UL)
+
+    typedef enum
+    {
+        __SG_ROUTINE_NEW,
+        __SG_ROUTINE_RUNNING,
+        __SG_ROUTINE_STOPPED
+    } __sgRoutineStatus;
+
+    typedef struct
+    {
+        __sgMpscNode node;
+        uint8_t stop;
+    } __sgRoutineEvent;
+
+    struct __sgHandler;
 
     typedef struct
     {
+        struct __sgHandler *h;
+        sgRoutine fn;
+        void *arg;
         pthread_t id;
+        sgRoutineId rid;
         uint8_t sts;
-        UT_hash_handle hh;
-    } __sgRoutineHash;
+        uint32_t node;
+        int cpu;
+        uint8_t prio;
+        size_t stackSize;
+        void *stack;
+        size_t stackMap;
+        __sgRoutineEvent startEv;
+        __sgRoutineEvent stopEv;
+    } __sgRoutineWrapperArgs;
 
-    typedef struct
+    typedef struct __sgHandler
     {
-        sgChan *startCh;
-        sgChan *stopCh;
-        sgContext *closeCtx;
-        __sgRoutineHash *table;
+        __sgMpsc events;
+        uint32_t evWake;
+        uint32_t evSleeping;
+        uint8_t closing;
+        uint8_t draining;
+        uint32_t spawning;
+        sgContext *ctx;
+        sgMode mode;
+        __sgSched *sched;
+        __sgSlab table;
+        uint64_t spawned;
+        uint64_t finished;
+        sgAffinity affinity;
+        sgCpuSet allowed;
+        int *cpus;
+        uint32_t nCpus;
+        uint32_t nextCpu;
+        size_t stackSize;
+        __sgAdmit admit;
         pthread_t sgHandlerThread;
     } __sgHandler;
+    typedef __sgHandler sgRuntime;
     extern __sgHandler *sgh;
 
+    typedef struct
+    {
+        sgMode mode;
+        uint64_t spawned;
+        uint64_t finished;
+        uint32_t workers;
+        uint64_t queued;
+        uint64_t queuedTotal;
+        uint64_t rejected;
+        uint64_t preempted;
+    } sgRuntimeStats;
+
     /*
-     * @brief   Adds new routine to the table.
-     * @param   id the thread ID
-     * @return  None.
+     * @brief   Adds new routine to the table, taking a preallocated slot.
+     * @param   h the handler
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @return  The routine's slot, or `NULL` if failed.
      */
-    void __sgHandlerAddRoutine(pthread_t id)
+    __sgRoutineWrapperArgs *__sgHandlerAddRoutine(__sgHandler *h, sgRoutine fn, void *arg)
     {
-        __sgRoutineHash *r = (__sgRoutineHash *)malloc(sizeof(__sgRoutineHash));
-        r->id = id;
-        r->sts = 0x00;
-        HASH_ADD_INT(sgh->table, id, r);
+        sgRoutineId rid;
+        __sgRoutineWrapperArgs *r = (__sgRoutineWrapperArgs *)__sgSlabAlloc(&h->table, &rid);
+        if (!r)
+            return NULL;
+
+        r->h = h;
+        r->fn = fn;
+        r->arg = arg;
+        r->rid = rid;
+        r->sts = __SG_ROUTINE_NEW;
+        r->node = 0;
+        r->cpu = -1;
+        r->prio = SG_PRIO_NORMAL;
+        r->stackSize = 0;
+        r->stack = NULL;
+        r->startEv.stop = 0x00;
+
+        if (h->affinity == SG_AFFINITY_CPU && h->nCpus > 0)
+            r->cpu = h->cpus[__atomic_fetch_add(&h->nextCpu, 1, __ATOMIC_RELAXED) % h->nCpus];
+        else if (h->affinity == SG_AFFINITY_NODE)
+            r->node = sgNumaCurrentNode();
+
+        r->stopEv.stop = 0x01;
+        return r;
     }
 
     /*
      * @brief   Finds routine from the table.
-     * @param   id the thread ID
-     * @return  The hash.
+     * @param   h the handler
+     * @param   rid the routine ID
+     * @return  The routine's slot, or `NULL` if the routine has already been removed.
      */
-    __sgRoutineHash *__sgHandlerFindRoutine(pthread_t id)
+    __sgRoutineWrapperArgs *__sgHandlerFindRoutine(__sgHandler *h, sgRoutineId rid)
     {
-        __sgRoutineHash *r;
-        HASH_FIND_INT(sgh->table, &id, r);
-        return r;
+        return (__sgRoutineWrapperArgs *)__sgSlabGet(&h->table, rid);
     }
 
     /*
-     * @brief   Removes routine from the table.
-     * @param   id the thread ID
+     * @brief   Removes routine from the table. Its ID turns stale.
+     * @param   h the handler
+     * @param   r the routine's slot
      * @return  None.
      */
-    void __sgHandlerRemoveRoutine(pthread_t id)
+    void __sgHandlerRemoveRoutine(__sgHandler *h, __sgRoutineWrapperArgs *r)
     {
-        __sgRoutineHash *r = __sgHandlerFindRoutine(id);
-        if (r)
-        {
-            HASH_DEL(sgh->table, r);
-            free(r);
-        }
+        __sgSlabFree(&h->table, r);
+    }
+
+    /*
+     * @brief   Terminates a routine of the table if it is running.
+     * @param   a the routine's slot
+     * @return  None.
+     */
+    void __sgHandlerTerminateRoutine(void *a)
+    {
+        __sgRoutineWrapperArgs *r = (__sgRoutineWrapperArgs *)a;
+        if (r->sts == __SG_ROUTINE_RUNNING)
+            pthread_cancel(r->id);
     }
 
     /*
      * @brief   Terminates all routines inside the table.
-     * @param   none
+     * @param   h the handler
      * @return  None.
      */
-    void __sgHandlerTerminateRoutines()
+    void __sgHandlerTerminateRoutines(__sgHandler *h)
     {
-        __sgRoutineHash *r, *tmp;
-        HASH_ITER(hh, sgh->table, r, tmp)
+        __sgSlabForEach(&h->table, __sgHandlerTerminateRoutine);
+    }
+
+    /*
+     * @brief   Announces a spawn on a runtime, unless the runtime is draining.
+     * @param   h the handler
+     * @return  `1` if the spawn may go on, in which case `__sgHandlerSpawnLeave()` must follow. `0` if the runtime no longer accepts spawns.
+     * @note    The spawn is announced before the draining flag is read, and a shutdown raises the flag before it reads the announcements, so either the spawn is refused or the shutdown waits for it.
+     */
+    uint8_t __sgHandlerSpawnEnter(__sgHandler *h)
+    {
+        __atomic_fetch_add(&h->spawning, 1, __ATOMIC_SEQ_CST);
+        if (!__atomic_load_n(&h->draining, __ATOMIC_SEQ_CST))
+            return 0x01;
+
+        __atomic_fetch_sub(&h->spawning, 1, __ATOMIC_RELEASE);
+        return 0x00;
+    }
+
+    /*
+     * @brief   Ends a spawn announced by `__sgHandlerSpawnEnter()`.
+     * @param   h the handler
+     * @return  None.
+     */
+    void __sgHandlerSpawnLeave(__sgHandler *h)
+    {
+        __atomic_fetch_sub(&h->spawning, 1, __ATOMIC_RELEASE);
+    }
+
+    /*
+     * @brief   Posts a chain of routine events to the handler, waking it only if it is asleep.
+     * @param   h the handler
+     * @param   first the first event, linked through its node to the last one
+     * @param   last the last event
+     * @return  None.
+     */
+    void __sgHandlerPostChain(__sgHandler *h, __sgRoutineEvent *first, __sgRoutineEvent *last)
+    {
+        __sgMpscPushChain(&h->events, &first->node, &last->node);
+
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&h->evSleeping, __ATOMIC_SEQ_CST))
         {
-            pthread_cancel(r->id);
-            HASH_DEL(sgh->table, r);
-            free(r);
+            __atomic_store_n(&h->evWake, 1, __ATOMIC_RELEASE);
+            __sgFutexWake(&h->evWake, 1);
         }
     }
 
-    typedef struct
+    /*
+     * @brief   Posts a routine event to the handler, waking it only if it is asleep.
+     * @param   h the handler
+     * @param   ev the event
+     * @return  None.
+     */
+    void __sgHandlerPost(__sgHandler *h, __sgRoutineEvent *ev)
     {
-        pthread_t id;
-        sgRoutine fn;
-        void *arg;
-    } __sgRoutineWrapperArgs;
+        __sgHandlerPostChain(h, ev, ev);
+    }
+
+    /*
+     * @brief   Restricts the calling routine thread to the CPU or the NUMA node picked when it was spawned.
+     * @param   r the routine's slot
+     * @return  None.
+     */
+    void __sgHandlerPinRoutine(__sgRoutineWrapperArgs *r)
+    {
+        sgCpuSet mask;
+        if (r->cpu >= 0)
+        {
+            sgCpuSetClear(&mask);
+            sgCpuSetAdd(&mask, r->cpu);
+        }
+        else
+            __sgNumaNodeMask(r->node, &r->h->allowed, &mask);
+
+        __sgCpuSetApplySelf(&mask);
+    }
 
     /*
      * @brief   Wraps the routine function to fit the sego handler scheme.
@@ -106,47 +262,137 @@ extern "C"
     {
         __sgRoutineWrapperArgs *args = (__sgRoutineWrapperArgs *)a;
 
+        if (args->h->affinity != SG_AFFINITY_NONE)
+            __sgHandlerPinRoutine(args);
+
+        if (args->prio != SG_PRIO_NORMAL)
+            setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), (args->prio == SG_PRIO_REALTIME) ? -5 : 10);
+
+        __sgRoutineSelfTls = args->rid;
         args->fn(args->arg);
-        sgChanIn(sgh->stopCh, &args->id);
+        sgArenaDestroy(__sgRoutineArenaTls);
+        __sgRoutineArenaTls = NULL;
+
+        __sgHandlerPost(args->h, &args->stopEv);
+        return NULL;
+    }
+
+    /*
+     * @brief   Creates the thread of a routine on a guard-paged stack from the stack pool.
+     * @param   h the handler
+     * @param   r the routine's slot
+     * @return  `SG_ERR_ALLOC` if no stack could be mapped. `SG_ERR_PTHREAD` if the thread could not be created. `SG_OK` if ok.
+     * @note    The stack goes back to the pool once the handler has joined the thread. If the system refuses the stack, e.g. because it is too small for the thread's TLS, the thread gets a default stack instead.
+     */
+    sgReturnType __sgHandlerStartRoutine(__sgHandler *h, __sgRoutineWrapperArgs *r)
+    {
+        size_t size = (r->stackSize != 0) ? r->stackSize : h->stackSize;
+        if (size < SG_THREAD_STACK_MIN)
+            size = SG_THREAD_STACK_MIN;
+
+        r->stack = __sgStackAcquire(size, &r->stackMap);
+        if (!r->stack)
+            return SG_ERR_ALLOC;
+
+        size_t page = __sgStackPoolGet()->page;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setstack(&attr, (char *)r->stack + page, r->stackMap - page);
+        int ret = pthread_create(&r->id, &attr, __sgRoutineWrapper, (void *)r);
+        pthread_attr_destroy(&attr);
+
+        if (ret != 0)
+        {
+            __sgStackRelease(r->stack, r->stackMap);
+            r->stack = NULL;
+            if (pthread_create(&r->id, NULL, __sgRoutineWrapper, (void *)r) != 0)
+                return SG_ERR_PTHREAD;
+        }
+
+        return SG_OK;
+    }
+
+    typedef struct
+    {
+        sgWaitGroup done;
+        sgRoutine fn;
+        void *arg;
+        void *result;
+    } sgHandle;
+
+    /*
+     * @brief   Wraps a joinable routine, keeping its return value in the handle.
+     * @param   a the handle
+     * @return  A void pointer.
+     */
+    void *__sgHandleRoutine(void *a)
+    {
+        sgHandle *h = (sgHandle *)a;
 
-        free(args);
+        h->result = h->fn(h->arg);
+        sgWaitGroupDone(&h->done);
         return NULL;
     }
 
     /*
-     * @brief   Handles all the sego routines. This runs in the background after `sgInit()`.
-     * @param   arg the routine argument
+     * @brief   Books a routine event. A routine is joined and removed once both its start and stop events arrived, in either order.
+     * @param   h the handler
+     * @param   ev the event
+     * @return  None.
+     */
+    void __sgHandlerBook(__sgHandler *h, __sgRoutineEvent *ev)
+    {
+        __sgRoutineWrapperArgs *r = ev->stop
+                                        ? (__sgRoutineWrapperArgs *)((char *)ev - offsetof(__sgRoutineWrapperArgs, stopEv))
+                                        : (__sgRoutineWrapperArgs *)((char *)ev - offsetof(__sgRoutineWrapperArgs, startEv));
+
+        if (ev->stop)
+            __atomic_store_n(&h->finished, h->finished + 1, __ATOMIC_RELAXED);
+
+        if (r->sts == __SG_ROUTINE_NEW)
+        {
+            r->sts = ev->stop ? __SG_ROUTINE_STOPPED : __SG_ROUTINE_RUNNING;
+            return;
+        }
+
+        pthread_join(r->id, NULL);
+        __sgStackRelease(r->stack, r->stackMap);
+        __sgHandlerRemoveRoutine(h, r);
+    }
+
+    /*
+     * @brief   Handles all the sego routines of a runtime. This runs in the background after `sgInit()` or `sgRuntimeCreate()`.
+     * @param   arg the handler
      * @return  A void pointer.
+     * @note    Routines are spawned by the `sego()` caller itself. This routine only books their start and stop events, and sleeps on a futex while there are none.
      */
     void *__sgHandlerRoutine(void *arg)
     {
+        __sgHandler *h = (__sgHandler *)arg;
+
         while (1)
         {
-            sgSel sel = sgSelectWithContext(1, 2, sgh->closeCtx, sgh->startCh, sgh->stopCh);
+            __sgMpscNode *n;
+            while ((n = __sgMpscPop(&h->events)) != NULL)
+                __sgHandlerBook(h, (__sgRoutineEvent *)((char *)n - offsetof(__sgRoutineEvent, node)));
 
-            if (sel == (sgSel)sgh->closeCtx)
+            if (__atomic_load_n(&h->closing, __ATOMIC_ACQUIRE))
             {
-                __sgHandlerTerminateRoutines();
-                sgChanDestroy(sgh->startCh);
-                sgChanDestroy(sgh->stopCh);
-                sgContextDestroy(sgh->closeCtx);
+                __sgHandlerTerminateRoutines(h);
                 break;
             }
-            else if (sel == (sgSel)sgh->startCh)
-            {
-                __sgRoutineWrapperArgs *buf = (__sgRoutineWrapperArgs *)malloc(sizeof(__sgRoutineWrapperArgs));
-                sgChanOut(sgh->startCh, buf);
-                pthread_create(&buf->id, NULL, __sgRoutineWrapper, (void *)buf);
-                __sgHandlerAddRoutine(buf->id);
-            }
-            else if (sel == (sgSel)sgh->stopCh)
-            {
-                pthread_t buf;
-                sgChanOut(sgh->stopCh, &buf);
-                pthread_join(buf, NULL);
-                __sgHandlerRemoveRoutine(buf);
-            }
+
+            __atomic_store_n(&h->evWake, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&h->evSleeping, 1, __ATOMIC_SEQ_CST);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+            if (__sgMpscEmpty(&h->events) && !__atomic_load_n(&h->closing, __ATOMIC_SEQ_CST))
+                __sgFutexWait(&h->evWake, 0, -1);
+
+            __atomic_store_n(&h->evSleeping, 0, __ATOMIC_RELAXED);
         }
+
+        return NULL;
     }
 
 #ifdef __cplusplus
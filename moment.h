@@ -11,6 +11,7 @@ extern "C"
 #include <signal.h>
 #include <time.h>
 #include "enums.h"
+#include "park.h"
 
     typedef void (*sgTimerCallback)(void *);
 
@@ -19,9 +20,18 @@ extern "C"
      * @param   time sleep duration
      * @return  none
      * @note    Multiply the time with the desired time unit, e.g. 500L * `SG_TIME_MS` for 500ms sleep.
+     * @note    Inside a coroutine, only the calling routine is suspended.
      */
     void sgMomentSleep(int64_t time)
     {
+        if (__sgSchedCurrentTask() != NULL)
+        {
+            __sgParker p;
+            __sgParkerInit(&p);
+            __sgParkerWait(&p, NULL, (time < 0) ? 0 : time);
+            return;
+        }
+
         struct timespec ts = {
             .tv_sec = time / SG_TIME_S,
             .tv_nsec = time % SG_TIME_S};
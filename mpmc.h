@@ -0,0 +1,199 @@
+#ifndef __SEGO_MPMC_H
+#define __SEGO_MPMC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "alloc.h"
+
+    typedef struct
+    {
+        size_t tail __attribute__((aligned(64)));
+        size_t head __attribute__((aligned(64)));
+        uint32_t rxParked __attribute__((aligned(64)));
+        uint32_t txParked;
+        size_t mask __attribute__((aligned(64)));
+        size_t itemSize;
+        size_t slotSize;
+        char *slots;
+    } __sgMpmc;
+
+    /*
+     * @brief   Creates a bounded lock-free multi-producer multi-consumer ring.
+     * @param   itemSize the size for each item
+     * @param   bufferSize the minimum number of items it holds, rounded up to a power of two, at least 2
+     * @return  The pointer to the ring, or `NULL` if failed.
+     * @note    Each slot starts with a sequence number telling whose turn it is. A slot at position `i` is free for the producer of lap `i` when it holds `i`, and holds that producer's item for the consumer when it holds `i + 1`. With a single slot, `i + 1` would also mark it free for the next lap, so the ring has at least two.
+     */
+    __sgMpmc *__sgMpmcCreate(size_t itemSize, size_t bufferSize)
+    {
+        if (itemSize == 0 || bufferSize == 0 || bufferSize > SIZE_MAX / 2 || itemSize > SIZE_MAX / 2)
+            return NULL;
+
+        size_t cap = 2;
+        while (cap < bufferSize)
+            cap *= 2;
+
+        size_t slotSize = (sizeof(size_t) + itemSize + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+        if (cap > SIZE_MAX / slotSize)
+            return NULL;
+
+        __sgMpmc *q = (__sgMpmc *)__sgAlignedAlloc(64, sizeof(__sgMpmc));
+        if (!q)
+            return NULL;
+
+        q->slots = (char *)malloc(cap * slotSize);
+        if (!q->slots)
+        {
+            free(q);
+            return NULL;
+        }
+
+        for (size_t i = 0; i < cap; ++i)
+            *(size_t *)(q->slots + i * slotSize) = i;
+
+        q->tail = 0;
+        q->head = 0;
+        q->rxParked = 0;
+        q->txParked = 0;
+        q->mask = cap - 1;
+        q->itemSize = itemSize;
+        q->slotSize = slotSize;
+        return q;
+    }
+
+    /*
+     * @brief   Destroys the ring.
+     * @param   q the ring
+     * @return  None.
+     */
+    void __sgMpmcDestroy(__sgMpmc *q)
+    {
+        if (q == NULL)
+            return;
+
+        free(q->slots);
+        free(q);
+    }
+
+    /*
+     * @brief   Retrieves the sequence number of the slot at a position.
+     * @param   q the ring
+     * @param   pos the position
+     * @return  The pointer to the sequence number, followed by the item.
+     */
+    size_t *__sgMpmcSlot(__sgMpmc *q, size_t pos)
+    {
+        return (size_t *)(q->slots + (pos & q->mask) * q->slotSize);
+    }
+
+    /*
+     * @brief   Pushes an item unless the ring is full. Any thread may call this.
+     * @param   q the ring
+     * @param   data the item
+     * @return  `1` if pushed. Otherwise, `0`.
+     */
+    uint8_t __sgMpmcPush(__sgMpmc *q, const void *data)
+    {
+        size_t pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+        size_t *seq;
+
+        while (1)
+        {
+            seq = __sgMpmcSlot(q, pos);
+            intptr_t dif = (intptr_t)(__atomic_load_n(seq, __ATOMIC_ACQUIRE) - pos);
+            if (dif == 0)
+            {
+                if (__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    break;
+            }
+            else if (dif < 0)
+                return 0x00;
+            else
+                pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+        }
+
+        memcpy(seq + 1, data, q->itemSize);
+        __atomic_store_n(seq, pos + 1, __ATOMIC_RELEASE);
+        return 0x01;
+    }
+
+    /*
+     * @brief   Pops an item unless the ring is empty. Any thread may call this.
+     * @param   q the ring
+     * @param   buf the buffer to hold the item
+     * @return  `1` if popped. Otherwise, `0`.
+     */
+    uint8_t __sgMpmcPop(__sgMpmc *q, void *buf)
+    {
+        size_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+        size_t *seq;
+
+        while (1)
+        {
+            seq = __sgMpmcSlot(q, pos);
+            intptr_t dif = (intptr_t)(__atomic_load_n(seq, __ATOMIC_ACQUIRE) - (pos + 1));
+            if (dif == 0)
+            {
+                if (__atomic_compare_exchange_n(&q->head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    break;
+            }
+            else if (dif < 0)
+                return 0x00;
+            else
+                pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+        }
+
+        memcpy(buf, seq + 1, q->itemSize);
+        __atomic_store_n(seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+        return 0x01;
+    }
+
+    /*
+     * @brief   Checks whether the slot at the head or the tail of the ring has its turn, i.e. whether the next pop or push would succeed.
+     * @param   q the ring
+     * @param   at the head or the tail
+     * @param   turn `1` for the head, `0` for the tail
+     * @return  `1` if it has. Otherwise, `0`.
+     */
+    uint8_t __sgMpmcTurn(__sgMpmc *q, size_t *at, size_t turn)
+    {
+        while (1)
+        {
+            size_t pos = __atomic_load_n(at, __ATOMIC_SEQ_CST);
+            intptr_t dif = (intptr_t)(__atomic_load_n(__sgMpmcSlot(q, pos), __ATOMIC_SEQ_CST) - (pos + turn));
+            if (dif <= 0)
+                return dif == 0;
+        }
+    }
+
+    /*
+     * @brief   Checks whether the next item of the ring has been pushed. Any thread may call this.
+     * @param   q the ring
+     * @return  `1` if it has. Otherwise, `0`.
+     */
+    uint8_t __sgMpmcReady(__sgMpmc *q)
+    {
+        return __sgMpmcTurn(q, &q->head, 1);
+    }
+
+    /*
+     * @brief   Checks whether the ring has room for an item. Any thread may call this.
+     * @param   q the ring
+     * @return  `1` if it has. Otherwise, `0`.
+     */
+    uint8_t __sgMpmcRoom(__sgMpmc *q)
+    {
+        return __sgMpmcTurn(q, &q->tail, 0);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
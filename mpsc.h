@@ -0,0 +1,118 @@
+#ifndef __SEGO_MPSC_H
+#define __SEGO_MPSC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+    typedef struct __sgMpscNode
+    {
+        struct __sgMpscNode *next;
+    } __sgMpscNode;
+
+    typedef struct
+    {
+        __sgMpscNode *tail __attribute__((aligned(64)));
+        __sgMpscNode *head __attribute__((aligned(64)));
+        __sgMpscNode stub;
+    } __sgMpsc;
+
+    /*
+     * @brief   Initializes an intrusive lock-free multi-producer single-consumer queue (Vyukov).
+     * @param   q the queue
+     * @return  None.
+     */
+    void __sgMpscInit(__sgMpsc *q)
+    {
+        q->stub.next = NULL;
+        q->head = &q->stub;
+        q->tail = &q->stub;
+    }
+
+    /*
+     * @brief   Pushes a chain of nodes, already linked from `first` to `last`, with a single atomic exchange. Any thread may call this.
+     * @param   q the queue
+     * @param   first the first node of the chain
+     * @param   last the last node of the chain
+     * @return  None.
+     */
+    void __sgMpscPushChain(__sgMpsc *q, __sgMpscNode *first, __sgMpscNode *last)
+    {
+        __atomic_store_n(&last->next, NULL, __ATOMIC_RELAXED);
+        __sgMpscNode *prev = __atomic_exchange_n(&q->tail, last, __ATOMIC_ACQ_REL);
+        __atomic_store_n(&prev->next, first, __ATOMIC_RELEASE);
+    }
+
+    /*
+     * @brief   Pushes a node. Any thread may call this.
+     * @param   q the queue
+     * @param   n the node
+     * @return  None.
+     */
+    void __sgMpscPush(__sgMpsc *q, __sgMpscNode *n)
+    {
+        __sgMpscPushChain(q, n, n);
+    }
+
+    /*
+     * @brief   Pops the oldest node. Only one consumer at a time may call this.
+     * @param   q the queue
+     * @return  The node, or `NULL` if the queue is empty or a producer is still linking its node in.
+     */
+    __sgMpscNode *__sgMpscPop(__sgMpsc *q)
+    {
+        __sgMpscNode *head = q->head;
+        __sgMpscNode *next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+
+        if (head == &q->stub)
+        {
+            if (next == NULL)
+                return NULL;
+            q->head = next;
+            head = next;
+            next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+        }
+
+        if (next != NULL)
+        {
+            q->head = next;
+            return head;
+        }
+
+        if (head != __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE))
+            return NULL;
+
+        __sgMpscPush(q, &q->stub);
+        next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+        if (next != NULL)
+        {
+            q->head = next;
+            return head;
+        }
+
+        return NULL;
+    }
+
+    /*
+     * @brief   Checks whether the queue is empty, including pushes still in progress. Only the consumer may call this.
+     * @param   q the queue
+     * @return  `1` if empty. Otherwise, `0`.
+     */
+    uint8_t __sgMpscEmpty(__sgMpsc *q)
+    {
+        return (q->head == &q->stub &&
+                __atomic_load_n(&q->stub.next, __ATOMIC_ACQUIRE) == NULL &&
+                __atomic_load_n(&q->tail, __ATOMIC_SEQ_CST) == &q->stub)
+                   ? 0x01
+                   : 0x00;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
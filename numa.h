@@ -0,0 +1,346 @@
+#ifndef __SEGO_NUMA_H
+#define __SEGO_NUMA_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include "enums.h"
+
+#ifndef MAP_ANONYMOUS
+#ifdef MAP_ANON
+#define MAP_ANONYMOUS MAP_ANON
+#else
+#error "sego needs MAP_ANONYMOUS: define _DEFAULT_SOURCE (or _GNU_SOURCE), or include sego.h before any system header"
+#endif
+#endif
+
+#define SG_CPU_MAX 1024
+#define SG_NUMA_MAX_NODES 64
+#define SG_NUMA_LOCAL (-1)
+
+    typedef struct
+    {
+        uint64_t bits[SG_CPU_MAX / 64];
+    } sgCpuSet;
+
+    /*
+     * @brief   Empties a CPU set.
+     * @param   set the CPU set
+     * @return  None.
+     */
+    void sgCpuSetClear(sgCpuSet *set)
+    {
+        memset(set->bits, 0, sizeof(set->bits));
+    }
+
+    /*
+     * @brief   Adds a CPU to a CPU set.
+     * @param   set the CPU set
+     * @param   cpu the CPU
+     * @return  None.
+     */
+    void sgCpuSetAdd(sgCpuSet *set, int cpu)
+    {
+        if (cpu >= 0 && cpu < SG_CPU_MAX)
+            set->bits[cpu / 64] |= 1ULL << (cpu % 64);
+    }
+
+    /*
+     * @brief   Checks whether a CPU is in a CPU set.
+     * @param   set the CPU set
+     * @param   cpu the CPU
+     * @return  `1` if it is. Otherwise, `0`.
+     */
+    uint8_t sgCpuSetHas(const sgCpuSet *set, int cpu)
+    {
+        if (cpu < 0 || cpu >= SG_CPU_MAX)
+            return 0x00;
+
+        return (set->bits[cpu / 64] >> (cpu % 64)) & 1;
+    }
+
+    typedef struct
+    {
+        uint32_t nNodes;
+        int nodeId[SG_NUMA_MAX_NODES];
+        sgCpuSet cpus[SG_NUMA_MAX_NODES];
+        int16_t cpuNode[SG_CPU_MAX];
+    } __sgNumaTopo;
+
+    __sgNumaTopo __sgNumaTopology;
+    pthread_once_t __sgNumaOnce = PTHREAD_ONCE_INIT;
+
+    /*
+     * @brief   Parses a sysfs list such as `0-3,8-11` into a CPU set.
+     * @param   path the sysfs file
+     * @param   set holds the parsed entries
+     * @return  `SG_ERR_INVALID` if the file could not be read. `SG_OK` if ok.
+     */
+    sgReturnType __sgNumaReadList(const char *path, sgCpuSet *set)
+    {
+        FILE *f = fopen(path, "r");
+        if (!f)
+            return SG_ERR_INVALID;
+
+        char buf[4096];
+        size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+        fclose(f);
+        buf[len] = '\0';
+
+        sgCpuSetClear(set);
+        char *p = buf;
+        while (*p != '\0' && *p != '\n')
+        {
+            char *end;
+            long lo = strtol(p, &end, 10);
+            if (end == p)
+                break;
+
+            long hi = lo;
+            p = end;
+            if (*p == '-')
+            {
+                hi = strtol(p + 1, &end, 10);
+                p = end;
+            }
+
+            for (long i = lo; i <= hi && i < SG_CPU_MAX; ++i)
+                sgCpuSetAdd(set, (int)i);
+
+            if (*p == ',')
+                ++p;
+        }
+
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Reads the NUMA topology from sysfs. A machine without it is treated as one node holding every CPU.
+     * @param   none
+     * @return  None.
+     */
+    void __sgNumaLoad()
+    {
+        __sgNumaTopo *t = &__sgNumaTopology;
+        sgCpuSet online;
+
+        t->nNodes = 0;
+        for (int i = 0; i < SG_CPU_MAX; ++i)
+            t->cpuNode[i] = 0;
+
+        if (__sgNumaReadList("/sys/devices/system/node/online", &online) == SG_OK)
+        {
+            for (int n = 0; n < SG_CPU_MAX && t->nNodes < SG_NUMA_MAX_NODES; ++n)
+            {
+                if (!sgCpuSetHas(&online, n))
+                    continue;
+
+                char path[64];
+                snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+                if (__sgNumaReadList(path, &t->cpus[t->nNodes]) != SG_OK)
+                    continue;
+
+                uint8_t any = 0x00;
+                for (int c = 0; c < SG_CPU_MAX; ++c)
+                {
+                    if (sgCpuSetHas(&t->cpus[t->nNodes], c))
+                    {
+                        t->cpuNode[c] = (int16_t)t->nNodes;
+                        any = 0x01;
+                    }
+                }
+                if (!any)
+                    continue;
+
+                t->nodeId[t->nNodes] = n;
+                t->nNodes += 1;
+            }
+        }
+
+        if (t->nNodes == 0)
+        {
+            sgCpuSetClear(&t->cpus[0]);
+            for (int c = 0; c < SG_CPU_MAX; ++c)
+                sgCpuSetAdd(&t->cpus[0], c);
+            t->nodeId[0] = 0;
+            t->nNodes = 1;
+        }
+    }
+
+    /*
+     * @brief   Retrieves the NUMA topology, reading it on first use.
+     * @param   none
+     * @return  The topology.
+     */
+    __sgNumaTopo *__sgNumaGet()
+    {
+        pthread_once(&__sgNumaOnce, __sgNumaLoad);
+        return &__sgNumaTopology;
+    }
+
+    /*
+     * @brief   Retrieves the number of NUMA nodes.
+     * @param   none
+     * @return  The number of nodes, at least `1`.
+     */
+    uint32_t sgNumaNodes()
+    {
+        return __sgNumaGet()->nNodes;
+    }
+
+    /*
+     * @brief   Retrieves the NUMA node of a CPU.
+     * @param   cpu the CPU
+     * @return  The node, numbered from `0` to `sgNumaNodes() - 1`.
+     */
+    uint32_t __sgNumaNodeOfCpu(int cpu)
+    {
+        if (cpu < 0 || cpu >= SG_CPU_MAX)
+            return 0;
+
+        return (uint32_t)__sgNumaGet()->cpuNode[cpu];
+    }
+
+    /*
+     * @brief   Retrieves the NUMA node the calling thread is running on.
+     * @param   none
+     * @return  The node, numbered from `0` to `sgNumaNodes() - 1`.
+     */
+    uint32_t sgNumaCurrentNode()
+    {
+        __sgNumaTopo *t = __sgNumaGet();
+        if (t->nNodes == 1)
+            return 0;
+
+        unsigned int cpu = 0;
+        if (syscall(SYS_getcpu, &cpu, NULL, NULL) != 0)
+            return 0;
+
+        return __sgNumaNodeOfCpu((int)cpu);
+    }
+
+    /*
+     * @brief   Maps zeroed memory whose pages are preferably placed on a NUMA node.
+     * @param   size the size
+     * @param   node the node, or `SG_NUMA_LOCAL` for the caller's node
+     * @return  The pointer to the memory, or `NULL` if failed.
+     * @note    Release it with `__sgNumaFree()` and the same size.
+     */
+    void *__sgNumaAlloc(size_t size, int node)
+    {
+        void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            return NULL;
+
+        __sgNumaTopo *t = __sgNumaGet();
+        uint32_t n = (node < 0) ? sgNumaCurrentNode() : (uint32_t)node;
+        if (t->nNodes > 1 && n < t->nNodes)
+        {
+            unsigned long mask[SG_NUMA_MAX_NODES / (8 * sizeof(unsigned long)) + 1] = {0};
+            int id = t->nodeId[n];
+            mask[id / (8 * sizeof(unsigned long))] |= 1UL << (id % (8 * sizeof(unsigned long)));
+            syscall(SYS_mbind, p, size, MPOL_PREFERRED, mask, sizeof(mask) * 8, 0);
+        }
+
+        return p;
+    }
+
+    /*
+     * @brief   Releases memory from `__sgNumaAlloc()`.
+     * @param   p the pointer to the memory
+     * @param   size the size given to `__sgNumaAlloc()`
+     * @return  None.
+     */
+    void __sgNumaFree(void *p, size_t size)
+    {
+        if (p != NULL)
+            munmap(p, size);
+    }
+
+    /*
+     * @brief   Retrieves the CPU affinity mask of the calling thread.
+     * @param   set holds the mask
+     * @return  `SG_ERR_INVALID` if it could not be read. `SG_OK` if ok.
+     */
+    sgReturnType __sgCpuSetGetSelf(sgCpuSet *set)
+    {
+        sgCpuSetClear(set);
+        return (syscall(SYS_sched_getaffinity, 0, sizeof(set->bits), set->bits) < 0) ? SG_ERR_INVALID : SG_OK;
+    }
+
+    /*
+     * @brief   Restricts the calling thread to a CPU set.
+     * @param   set the CPU set
+     * @return  `SG_ERR_INVALID` if the kernel refused the mask. `SG_OK` if ok.
+     */
+    sgReturnType __sgCpuSetApplySelf(const sgCpuSet *set)
+    {
+        return (syscall(SYS_sched_setaffinity, 0, sizeof(set->bits), set->bits) != 0) ? SG_ERR_INVALID : SG_OK;
+    }
+
+    /*
+     * @brief   Lists the CPUs usable for workers, grouped node by node.
+     * @param   allowed the CPUs to use, or `NULL` for the process affinity mask
+     * @param   cpus holds the CPUs, at least `SG_CPU_MAX` entries
+     * @return  The number of CPUs listed.
+     */
+    uint32_t __sgNumaCpuOrder(const sgCpuSet *allowed, int *cpus)
+    {
+        sgCpuSet mask;
+        sgCpuSetClear(&mask);
+        if (allowed != NULL)
+            mask = *allowed;
+        else if (__sgCpuSetGetSelf(&mask) != SG_OK)
+            for (int c = 0; c < SG_CPU_MAX; ++c)
+                sgCpuSetAdd(&mask, c);
+
+        __sgNumaTopo *t = __sgNumaGet();
+        long nCpus = sysconf(_SC_NPROCESSORS_CONF);
+        uint32_t n = 0;
+
+        for (uint32_t node = 0; node < t->nNodes; ++node)
+            for (int c = 0; c < SG_CPU_MAX && c < nCpus; ++c)
+                if (sgCpuSetHas(&mask, c) && t->cpuNode[c] == (int16_t)node)
+                    cpus[n++] = c;
+
+        return n;
+    }
+
+    /*
+     * @brief   Retrieves the CPUs of a NUMA node that are also in an allowed set.
+     * @param   node the node
+     * @param   allowed the allowed CPUs
+     * @param   out holds the CPUs, or the whole allowed set if none of them is on the node
+     * @return  None.
+     */
+    void __sgNumaNodeMask(uint32_t node, const sgCpuSet *allowed, sgCpuSet *out)
+    {
+        __sgNumaTopo *t = __sgNumaGet();
+        uint64_t any = 0;
+
+        for (size_t i = 0; i < SG_CPU_MAX / 64; ++i)
+        {
+            out->bits[i] = allowed->bits[i] & ((node < t->nNodes) ? t->cpus[node].bits[i] : 0);
+            any |= out->bits[i];
+        }
+
+        if (!any)
+            *out = *allowed;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
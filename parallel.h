@@ -0,0 +1,265 @@
+#ifndef __SEGO_PARALLEL_H
+#define __SEGO_PARALLEL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "enums.h"
+#include "alloc.h"
+#include "sync.h"
+#include "scheduler.h"
+#include "waitgroup.h"
+
+    typedef void (*sgRangeFn)(int64_t begin, int64_t end, void *arg);
+    typedef void (*sgReduceFn)(int64_t begin, int64_t end, void *acc, void *arg);
+    typedef void (*sgCombineFn)(void *acc, const void *other, void *arg);
+
+    typedef struct
+    {
+        uint32_t lock __attribute__((aligned(64)));
+        int64_t lo;
+        int64_t hi;
+    } __sgParallelSlot;
+
+    typedef struct
+    {
+        sgRangeFn forFn;
+        sgReduceFn reduceFn;
+        sgCombineFn combine;
+        void *arg;
+        void *result;
+        char *accs;
+        size_t accSize;
+        pthread_mutex_t resultLock;
+        int64_t grain;
+        int64_t remaining;
+        uint32_t nSlots;
+        uint32_t joined;
+        uint32_t refs;
+        sgWaitGroup done;
+        __sgParallelSlot *slots;
+    } __sgParallelJob;
+
+    /*
+     * @brief   Creates a parallel job, with the whole range in the caller's slot.
+     * @param   begin the first index
+     * @param   end the index past the last one
+     * @param   grain the number of indices run at once
+     * @param   nSlots the number of participants, caller included
+     * @param   accSize the size of the reduction value, `0` for a parallel for
+     * @param   result the reduction value, holding the identity every participant starts from, or `NULL` for a parallel for
+     * @return  The job, or `NULL` if failed.
+     */
+    __sgParallelJob *__sgParallelJobCreate(int64_t begin, int64_t end, int64_t grain, uint32_t nSlots, size_t accSize, void *result)
+    {
+        __sgParallelJob *j = (__sgParallelJob *)malloc(sizeof(__sgParallelJob));
+        if (!j)
+            return NULL;
+
+        j->slots = (__sgParallelSlot *)__sgAlignedAlloc(64, sizeof(__sgParallelSlot) * nSlots);
+        j->accs = (accSize > 0) ? (char *)malloc(accSize * nSlots) : NULL;
+        if (!j->slots || (accSize > 0 && !j->accs) || __sgWaitGroupInit(&j->done) != SG_OK)
+        {
+            free(j->slots);
+            free(j->accs);
+            free(j);
+            return NULL;
+        }
+
+        for (uint32_t i = 0; i < nSlots; ++i)
+        {
+            j->slots[i].lock = 0;
+            j->slots[i].lo = (i == 0) ? begin : 0;
+            j->slots[i].hi = (i == 0) ? end : 0;
+            if (accSize > 0)
+                memcpy(j->accs + accSize * i, result, accSize);
+        }
+
+        pthread_mutex_init(&j->resultLock, NULL);
+        j->forFn = NULL;
+        j->reduceFn = NULL;
+        j->combine = NULL;
+        j->arg = NULL;
+        j->result = result;
+        j->accSize = accSize;
+        j->grain = grain;
+        j->remaining = end - begin;
+        j->nSlots = nSlots;
+        j->joined = 1;
+        j->refs = 1;
+        sgWaitGroupAdd(&j->done, 1);
+        return j;
+    }
+
+    /*
+     * @brief   Drops a reference to a parallel job, and frees it with the last one.
+     * @param   j the job
+     * @return  None.
+     */
+    void __sgParallelJobRelease(__sgParallelJob *j)
+    {
+        if (__atomic_sub_fetch(&j->refs, 1, __ATOMIC_ACQ_REL) != 0)
+            return;
+
+        __sgWaitGroupDeinit(&j->done);
+        pthread_mutex_destroy(&j->resultLock);
+        free(j->slots);
+        free(j->accs);
+        free(j);
+    }
+
+    /*
+     * @brief   Locks a slot of a parallel job.
+     * @param   s the slot
+     * @return  None.
+     */
+    void __sgParallelSlotLock(__sgParallelSlot *s)
+    {
+        while (__atomic_exchange_n(&s->lock, 1, __ATOMIC_ACQUIRE) != 0)
+            while (__atomic_load_n(&s->lock, __ATOMIC_RELAXED) != 0)
+                __sgCpuRelax();
+    }
+
+    /*
+     * @brief   Unlocks a slot of a parallel job.
+     * @param   s the slot
+     * @return  None.
+     */
+    void __sgParallelSlotUnlock(__sgParallelSlot *s)
+    {
+        __atomic_store_n(&s->lock, 0, __ATOMIC_RELEASE);
+    }
+
+    /*
+     * @brief   Takes up to one grain of indices from the front of a participant's own range.
+     * @param   j the job
+     * @param   self the participant's slot
+     * @param   lo holds the first index taken
+     * @param   hi holds the index past the last one taken
+     * @return  `1` if any was taken. Otherwise, `0`.
+     */
+    uint8_t __sgParallelTake(__sgParallelJob *j, uint32_t self, int64_t *lo, int64_t *hi)
+    {
+        __sgParallelSlot *s = &j->slots[self];
+        uint8_t ok = 0x00;
+
+        __sgParallelSlotLock(s);
+        if (s->lo < s->hi)
+        {
+            *lo = s->lo;
+            *hi = (s->hi - s->lo > j->grain) ? s->lo + j->grain : s->hi;
+            __atomic_store_n(&s->lo, *hi, __ATOMIC_RELAXED);
+            ok = 0x01;
+        }
+        __sgParallelSlotUnlock(s);
+
+        return ok;
+    }
+
+    /*
+     * @brief   Steals the back half of the largest-looking range of another participant into a participant's own slot.
+     * @param   j the job
+     * @param   self the participant's slot
+     * @return  `1` if a range was stolen. `0` if no other participant holds more than one grain.
+     */
+    uint8_t __sgParallelSteal(__sgParallelJob *j, uint32_t self)
+    {
+        for (uint32_t i = 1; i < j->nSlots; ++i)
+        {
+            __sgParallelSlot *v = &j->slots[(self + i) % j->nSlots];
+            if (__atomic_load_n(&v->hi, __ATOMIC_RELAXED) - __atomic_load_n(&v->lo, __ATOMIC_RELAXED) <= j->grain)
+                continue;
+
+            int64_t lo = 0, hi = 0;
+            __sgParallelSlotLock(v);
+            if (v->hi - v->lo > j->grain)
+            {
+                lo = v->lo + (v->hi - v->lo) / 2;
+                hi = v->hi;
+                __atomic_store_n(&v->hi, lo, __ATOMIC_RELAXED);
+            }
+            __sgParallelSlotUnlock(v);
+
+            if (lo == hi)
+                continue;
+
+            __sgParallelSlot *s = &j->slots[self];
+            __sgParallelSlotLock(s);
+            __atomic_store_n(&s->lo, lo, __ATOMIC_RELAXED);
+            __atomic_store_n(&s->hi, hi, __ATOMIC_RELAXED);
+            __sgParallelSlotUnlock(s);
+            return 0x01;
+        }
+
+        return 0x00;
+    }
+
+    /*
+     * @brief   Runs a participant of a parallel job until no range is left to take or steal, then merges its reduction value.
+     * @param   j the job
+     * @param   self the participant's slot
+     * @return  None.
+     * @note    The participant that runs the last index releases the job's waiter.
+     * @note    Between grains, a participant running as a coroutine stops at a checkpoint, so a long loop can be preempted.
+     */
+    void __sgParallelWork(__sgParallelJob *j, uint32_t self)
+    {
+        void *acc = (j->accs != NULL) ? j->accs + j->accSize * self : NULL;
+        int64_t ran = 0, lo, hi;
+        while (1)
+        {
+            if (!__sgParallelTake(j, self, &lo, &hi))
+            {
+                if (!__sgParallelSteal(j, self))
+                    break;
+                continue;
+            }
+
+            if (j->forFn != NULL)
+                j->forFn(lo, hi, j->arg);
+            else
+                j->reduceFn(lo, hi, acc, j->arg);
+            ran += hi - lo;
+            __sgSchedCheckpoint();
+        }
+
+        if (ran > 0 && acc != NULL)
+        {
+            pthread_mutex_lock(&j->resultLock);
+            j->combine(j->result, acc, j->arg);
+            pthread_mutex_unlock(&j->resultLock);
+        }
+
+        if (ran > 0 && __atomic_sub_fetch(&j->remaining, ran, __ATOMIC_ACQ_REL) == 0)
+            sgWaitGroupDone(&j->done);
+    }
+
+    /*
+     * @brief   The routine of a helper participant of a parallel job.
+     * @param   a the job
+     * @return  A void pointer.
+     * @note    A helper starting after every slot is taken, or after the job is done, only drops its reference.
+     */
+    void *__sgParallelHelper(void *a)
+    {
+        __sgParallelJob *j = (__sgParallelJob *)a;
+
+        uint32_t self = __atomic_fetch_add(&j->joined, 1, __ATOMIC_RELAXED);
+        if (self < j->nSlots && __atomic_load_n(&j->remaining, __ATOMIC_ACQUIRE) > 0)
+            __sgParallelWork(j, self);
+
+        __sgParallelJobRelease(j);
+        return NULL;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,259 @@
+#ifndef __SEGO_PARK_H
+#define __SEGO_PARK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "enums.h"
+#include "sync.h"
+#include "scheduler.h"
+
+    typedef enum
+    {
+        __SG_PARKER_WAITING,
+        __SG_PARKER_CLAIMED,
+        __SG_PARKER_SIGNALED,
+        __SG_PARKER_TIMEDOUT
+    } __sgParkerState;
+
+    typedef struct
+    {
+        __sgTimerEntry timer;
+        uint32_t state;
+        void *sel;
+        __sgTask *task;
+    } __sgParker;
+
+    typedef struct __sgWaitLink
+    {
+        __sgParker *p;
+        void *obj;
+        uint8_t linked;
+        struct __sgWaitLink *prev;
+        struct __sgWaitLink *next;
+    } __sgWaitLink;
+
+    typedef struct
+    {
+        __sgWaitLink *head;
+        __sgWaitLink *tail;
+    } __sgWaitList;
+
+    /*
+     * @brief   Prepares a parker for the calling routine, a coroutine or a plain thread.
+     * @param   p the parker
+     * @return  None.
+     */
+    void __sgParkerInit(__sgParker *p)
+    {
+        p->state = __SG_PARKER_WAITING;
+        p->sel = NULL;
+        p->task = __sgSchedCurrentTask();
+        p->timer.idx = SIZE_MAX;
+    }
+
+    /*
+     * @brief   Wakes the parker's owner, unless it has already been woken or has timed out.
+     * @param   p the parker
+     * @param   sel the object that caused the wake-up
+     * @return  `1` if this call woke the owner. Otherwise, `0`.
+     */
+    uint8_t __sgParkerSignal(__sgParker *p, void *sel)
+    {
+        uint32_t st = __SG_PARKER_WAITING;
+        if (!__atomic_compare_exchange_n(&p->state, &st, __SG_PARKER_CLAIMED, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return 0x00;
+
+        __sgTask *t = p->task;
+        p->sel = sel;
+        __atomic_store_n(&p->state, __SG_PARKER_SIGNALED, __ATOMIC_RELEASE);
+
+        if (t != NULL)
+            __sgSchedReady(t);
+        else
+            __sgFutexWake(&p->state, 1);
+
+        return 0x01;
+    }
+
+    /*
+     * @brief   Timer callback of a coroutine parker's timed wait.
+     * @param   e the parker's timer entry
+     * @return  None.
+     */
+    void __sgParkerTimeout(__sgTimerEntry *e)
+    {
+        __sgParker *p = (__sgParker *)((char *)e - offsetof(__sgParker, timer));
+
+        uint32_t st = __SG_PARKER_WAITING;
+        if (__atomic_compare_exchange_n(&p->state, &st, __SG_PARKER_TIMEDOUT, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            __sgSchedReady(p->task);
+    }
+
+    /*
+     * @brief   Blocks the owner until the parker is signaled or the timeout passes.
+     * @param   p the parker
+     * @param   unlock the mutex protecting the wait lists the parker is linked into, unlocked while waiting and not relocked, can be `NULL`
+     * @param   timeout the timeout, `-1` for infinite wait
+     * @return  `SG_TIMEOUT` if timeout. `SG_OK` if signaled.
+     * @note    A coroutine owner is suspended instead of blocking its worker. A wake-up left over from an earlier parker, whose signal raced with its owner, only suspends it again.
+     */
+    sgReturnType __sgParkerWait(__sgParker *p, pthread_mutex_t *unlock, int64_t timeout)
+    {
+        int64_t deadline = (timeout >= 0) ? __sgMonoNanos() + timeout : -1;
+
+        if (p->task != NULL)
+        {
+            if (deadline >= 0)
+            {
+                p->timer.when = deadline;
+                p->timer.fire = __sgParkerTimeout;
+                if (__sgSchedTimerAdd(p->task->sched, &p->timer) != SG_OK)
+                {
+                    uint32_t st = __SG_PARKER_WAITING;
+                    __atomic_compare_exchange_n(&p->state, &st, __SG_PARKER_TIMEDOUT, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+                }
+            }
+
+            if (__atomic_load_n(&p->state, __ATOMIC_ACQUIRE) == __SG_PARKER_WAITING)
+            {
+                __sgSchedCoPark(unlock);
+                while (__atomic_load_n(&p->state, __ATOMIC_ACQUIRE) == __SG_PARKER_WAITING)
+                    __sgSchedCoPark(NULL);
+            }
+            else if (unlock != NULL)
+                pthread_mutex_unlock(unlock);
+
+            if (deadline >= 0)
+                __sgSchedTimerDel(p->task->sched, &p->timer);
+
+            while (__atomic_load_n(&p->state, __ATOMIC_ACQUIRE) == __SG_PARKER_CLAIMED)
+                __sgCpuRelax();
+        }
+        else
+        {
+            if (unlock != NULL)
+                pthread_mutex_unlock(unlock);
+
+            while (1)
+            {
+                uint32_t st = __atomic_load_n(&p->state, __ATOMIC_ACQUIRE);
+                if (st == __SG_PARKER_SIGNALED || st == __SG_PARKER_TIMEDOUT)
+                    break;
+
+                if (st == __SG_PARKER_CLAIMED)
+                {
+                    __sgCpuRelax();
+                    continue;
+                }
+
+                int64_t remaining = -1;
+                if (deadline >= 0)
+                {
+                    remaining = deadline - __sgMonoNanos();
+                    if (remaining <= 0)
+                    {
+                        __atomic_compare_exchange_n(&p->state, &st, __SG_PARKER_TIMEDOUT, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+                        continue;
+                    }
+                }
+
+                __sgFutexWait(&p->state, __SG_PARKER_WAITING, remaining);
+            }
+        }
+
+        return (__atomic_load_n(&p->state, __ATOMIC_ACQUIRE) == __SG_PARKER_TIMEDOUT) ? SG_TIMEOUT : SG_OK;
+    }
+
+    /*
+     * @brief   Links a parker into a wait list. The caller must hold the lock protecting the list.
+     * @param   l the wait list
+     * @param   link the link, usually on the waiter's stack
+     * @param   p the parker
+     * @param   obj the object owning the wait list
+     * @return  None.
+     */
+    void __sgWaitListAdd(__sgWaitList *l, __sgWaitLink *link, __sgParker *p, void *obj)
+    {
+        link->p = p;
+        link->obj = obj;
+        link->linked = 0x01;
+        link->next = NULL;
+        link->prev = l->tail;
+
+        if (l->tail == NULL)
+            l->head = link;
+        else
+            l->tail->next = link;
+        l->tail = link;
+    }
+
+    /*
+     * @brief   Unlinks a link from a wait list if it is still linked. The caller must hold the lock protecting the list.
+     * @param   l the wait list
+     * @param   link the link
+     * @return  None.
+     */
+    void __sgWaitListRemove(__sgWaitList *l, __sgWaitLink *link)
+    {
+        if (!link->linked)
+            return;
+
+        if (link->prev == NULL)
+            l->head = link->next;
+        else
+            link->prev->next = link->next;
+
+        if (link->next == NULL)
+            l->tail = link->prev;
+        else
+            link->next->prev = link->prev;
+
+        link->linked = 0x00;
+    }
+
+    /*
+     * @brief   Wakes the first waiter in the list that has not been woken elsewhere. The caller must hold the lock protecting the list.
+     * @param   l the wait list
+     * @param   sel the object that caused the wake-up
+     * @return  `1` if a waiter was woken. Otherwise, `0`.
+     */
+    uint8_t __sgWaitListWakeOne(__sgWaitList *l, void *sel)
+    {
+        while (l->head != NULL)
+        {
+            __sgWaitLink *link = l->head;
+            __sgWaitListRemove(l, link);
+            if (__sgParkerSignal(link->p, sel))
+                return 0x01;
+        }
+
+        return 0x00;
+    }
+
+    /*
+     * @brief   Wakes every waiter in the list. The caller must hold the lock protecting the list.
+     * @param   l the wait list
+     * @param   sel the object that caused the wake-up
+     * @return  None.
+     */
+    void __sgWaitListWakeAll(__sgWaitList *l, void *sel)
+    {
+        while (l->head != NULL)
+        {
+            __sgWaitLink *link = l->head;
+            __sgWaitListRemove(l, link);
+            __sgParkerSignal(link->p, sel);
+        }
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
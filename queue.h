@@ -10,30 +10,87 @@ extern "C"
 #include <stdint.h>
 #include <string.h>
 #include "enums.h"
+#include "numa.h"
 
-    typedef struct __sgQueueItem
-    {
-        void *ptr;
-        struct __sgQueueItem *next;
-    } sgQueueItem;
+#define __SG_QUEUE_PREALLOC (64UL * 1024UL)
+#define __SG_QUEUE_HEAP (-2)
 
     typedef struct
     {
         uint32_t waiting;
         size_t itemSize;
         size_t bufferSize;
-        sgQueueItem *head;
-        sgQueueItem *tail;
+        char *ring;
+        size_t cap;
+        size_t head;
+        int node;
     } sgQueue;
 
     /*
-     * @brief   Creates a queue with fixed item size.
+     * @brief   Allocates the ring of a queue.
+     * @param   q the queue
+     * @param   cap the number of slots
+     * @return  The pointer to the ring, or `NULL` if failed.
+     */
+    char *__sgQueueRingAlloc(sgQueue *q, size_t cap)
+    {
+        if (q->node == __SG_QUEUE_HEAP)
+            return (char *)malloc(q->itemSize * cap);
+
+        return (char *)__sgNumaAlloc(q->itemSize * cap, q->node);
+    }
+
+    /*
+     * @brief   Releases the ring of a queue.
+     * @param   q the queue
+     * @param   ring the ring
+     * @param   cap the number of slots it was allocated with
+     * @return  None.
+     */
+    void __sgQueueRingFree(sgQueue *q, char *ring, size_t cap)
+    {
+        if (q->node == __SG_QUEUE_HEAP)
+            free(ring);
+        else
+            __sgNumaFree(ring, q->itemSize * cap);
+    }
+
+    /*
+     * @brief   Doubles the ring of a queue, moving its items to the front in order.
+     * @param   q the queue
+     * @return  `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     */
+    sgReturnType __sgQueueGrow(sgQueue *q)
+    {
+        if (q->cap > SIZE_MAX / 2 / q->itemSize)
+            return SG_ERR_ALLOC;
+
+        char *ring = __sgQueueRingAlloc(q, q->cap * 2);
+        if (!ring)
+            return SG_ERR_ALLOC;
+
+        size_t first = q->cap - q->head;
+        if (first > q->waiting)
+            first = q->waiting;
+
+        memcpy(ring, q->ring + q->head * q->itemSize, first * q->itemSize);
+        memcpy(ring + first * q->itemSize, q->ring, (q->waiting - first) * q->itemSize);
+
+        __sgQueueRingFree(q, q->ring, q->cap);
+        q->ring = ring;
+        q->cap *= 2;
+        q->head = 0;
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Creates a queue with fixed item size, whose ring lives on the heap or in the memory of a NUMA node.
      * @param   itemSize the size for each item
      * @param   bufferSize the size of the queue
-     * @return  The pointer to the queue (`sgQueue`) instance.
-     * @note    If the queue is full when a new item is being queued, the earliest one gets dequeued.
+     * @param   node the node, `SG_NUMA_LOCAL` for the caller's node, or `__SG_QUEUE_HEAP` for the heap
+     * @return  The pointer to the queue (`sgQueue`) instance, or `NULL` if failed.
      */
-    sgQueue *sgQueueCreate(size_t itemSize, size_t bufferSize)
+    sgQueue *__sgQueueCreate(size_t itemSize, size_t bufferSize, int node)
     {
         if (itemSize == 0 || bufferSize == 0)
             return NULL;
@@ -45,16 +102,41 @@ extern "C"
         q->waiting = 0;
         q->itemSize = itemSize;
         q->bufferSize = bufferSize;
-        q->head = NULL;
-        q->tail = NULL;
+        q->head = 0;
+        q->node = node;
+
+        q->cap = 1;
+        while (q->cap < bufferSize && q->cap * 2 <= __SG_QUEUE_PREALLOC / itemSize)
+            q->cap *= 2;
+
+        q->ring = __sgQueueRingAlloc(q, q->cap);
+        if (!q->ring)
+        {
+            free(q);
+            return NULL;
+        }
+
         return q;
     }
 
+    /*
+     * @brief   Creates a queue with fixed item size.
+     * @param   itemSize the size for each item
+     * @param   bufferSize the size of the queue
+     * @return  The pointer to the queue (`sgQueue`) instance.
+     * @note    If the queue is full when a new item is being queued, the earliest one gets dequeued.
+     * @note    Items are copied into a ring with a power-of-two number of slots. It is allocated up front for up to 64 KiB of items, and doubles as needed beyond that, up to `bufferSize` items.
+     */
+    sgQueue *sgQueueCreate(size_t itemSize, size_t bufferSize)
+    {
+        return __sgQueueCreate(itemSize, bufferSize, __SG_QUEUE_HEAP);
+    }
+
     /*
      * @brief   Queues new item.
      * @param   q the queue instance
      * @param   data the new item
-     * @return  `SG_ERR_NULLPTR` if one argument is a `NULL`. `SG_ERR_ALLOC` if a new memory allocation is somehow failed. `SG_OK` if ok.
+     * @return  `SG_ERR_NULLPTR` if one argument is a `NULL`. `SG_ERR_ALLOC` if a new memory allocation is somehow failed. `SG_QUEUE_FULL` if the earliest item was dropped to make room. `SG_OK` if ok.
      */
     sgReturnType sgQueueQueue(sgQueue *q, void *data)
     {
@@ -66,42 +148,13 @@ extern "C"
         if (q->waiting == q->bufferSize)
         {
             isFull = 0x01;
-
-            sgQueueItem *prevHead = q->head;
-            q->head = q->head->next;
-
-            if (q->head == NULL)
-                q->tail = NULL;
-
-            free(prevHead->ptr);
-            free(prevHead);
+            q->head = (q->head + 1) & (q->cap - 1);
             q->waiting -= 1;
         }
-
-        sgQueueItem *newItem = (sgQueueItem *)malloc(sizeof(sgQueueItem));
-        if (!newItem)
-            return SG_ERR_ALLOC;
-
-        newItem->ptr = malloc(q->itemSize);
-        if (!newItem->ptr)
-        {
-            free(newItem);
+        else if (q->waiting == q->cap && __sgQueueGrow(q) != SG_OK)
             return SG_ERR_ALLOC;
-        }
-        memcpy(newItem->ptr, data, q->itemSize);
-        newItem->next = NULL;
-
-        if (q->waiting == 0)
-        {
-            q->head = newItem;
-            q->tail = newItem;
-        }
-        else
-        {
-            q->tail->next = newItem;
-            q->tail = newItem;
-        }
 
+        memcpy(q->ring + ((q->head + q->waiting) & (q->cap - 1)) * q->itemSize, data, q->itemSize);
         q->waiting += 1;
         return (isFull) ? SG_QUEUE_FULL : SG_OK;
     }
@@ -120,15 +173,8 @@ extern "C"
         if (q->waiting == 0)
             return SG_NOTHING;
 
-        sgQueueItem *prevHead = q->head;
-        memcpy(buf, q->head->ptr, q->itemSize);
-        q->head = q->head->next;
-
-        if (q->head == NULL)
-            q->tail = NULL;
-
-        free(prevHead->ptr);
-        free(prevHead);
+        memcpy(buf, q->ring + q->head * q->itemSize, q->itemSize);
+        q->head = (q->head + 1) & (q->cap - 1);
         q->waiting -= 1;
         return SG_OK;
     }
@@ -143,18 +189,7 @@ extern "C"
         if (q == NULL)
             return;
 
-        while (q->head != NULL)
-        {
-            sgQueueItem *prevHead = q->head;
-            q->head = q->head->next;
-
-            if (q->head == NULL)
-                q->tail = NULL;
-
-            free(prevHead->ptr);
-            free(prevHead);
-        }
-
+        __sgQueueRingFree(q, q->ring, q->cap);
         free(q);
     }
 
@@ -0,0 +1,1813 @@
+#ifndef __SEGO_SCHEDULER_H
+#define __SEGO_SCHEDULER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "enums.h"
+#include "alloc.h"
+#include "sync.h"
+#include "config.h"
+#include "coroutine.h"
+#include "mpsc.h"
+#include "slab.h"
+#include "numa.h"
+#include "arena.h"
+
+#define __SG_PRIO_CLASSES 3
+#define __SG_PRIO_FAIRNESS 61
+#define __SG_RUNNEXT_GRACE (5LL * SG_TIME_US)
+
+    typedef void *(*sgRoutine)(void *);
+
+    typedef uint64_t sgRoutineId;
+
+    typedef enum
+    {
+        __SG_TASK_RUNNING,
+        __SG_TASK_PARKED,
+        __SG_TASK_NOTIFIED
+    } __sgTaskState;
+
+    typedef enum
+    {
+        __SG_CO_FINISHED,
+        __SG_CO_PARKED,
+        __SG_CO_YIELDED
+    } __sgCoAction;
+
+    struct __sgSched;
+
+    typedef struct __sgTask
+    {
+        sgRoutine fn;
+        void *arg;
+        __sgMpscNode node;
+        struct __sgSched *sched;
+        __sgCo *co;
+        uint32_t state;
+        sgRoutineId id;
+        uint8_t prio;
+        int64_t deadline;
+        int64_t since;
+        uint64_t seq;
+        size_t heapIdx;
+        struct __sgTask *younger;
+        struct __sgTask *older;
+        size_t stackSize;
+        sgArena *arena;
+    } __sgTask;
+
+    typedef struct __sgDequeBuf
+    {
+        int64_t cap;
+        __sgTask **items;
+        struct __sgDequeBuf *retired;
+    } __sgDequeBuf;
+
+    typedef struct
+    {
+        int64_t top __attribute__((aligned(64)));
+        int64_t bottom __attribute__((aligned(64)));
+        __sgDequeBuf *buf __attribute__((aligned(64)));
+    } __sgDeque;
+
+    /*
+     * @brief   Allocates a ring buffer for the work-stealing deque.
+     * @param   cap the capacity, must be a power of two
+     * @return  The pointer to the buffer.
+     */
+    __sgDequeBuf *__sgDequeBufCreate(int64_t cap)
+    {
+        __sgDequeBuf *b = (__sgDequeBuf *)malloc(sizeof(__sgDequeBuf));
+        if (!b)
+            return NULL;
+
+        b->items = (__sgTask **)calloc((size_t)cap, sizeof(__sgTask *));
+        if (!b->items)
+        {
+            free(b);
+            return NULL;
+        }
+
+        b->cap = cap;
+        b->retired = NULL;
+        return b;
+    }
+
+    /*
+     * @brief   Initializes a work-stealing deque (Chase-Lev).
+     * @param   d the deque
+     * @param   cap the initial capacity, must be a power of two
+     * @return  `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     */
+    sgReturnType __sgDequeInit(__sgDeque *d, int64_t cap)
+    {
+        d->top = 0;
+        d->bottom = 0;
+        d->buf = __sgDequeBufCreate(cap);
+        return (d->buf == NULL) ? SG_ERR_ALLOC : SG_OK;
+    }
+
+    /*
+     * @brief   Pushes a task to the bottom of the deque. Only the owner worker may call this.
+     * @param   d the deque
+     * @param   t the task
+     * @return  `SG_ERR_ALLOC` if the deque failed to grow. `SG_OK` if ok.
+     */
+    sgReturnType __sgDequePush(__sgDeque *d, __sgTask *t)
+    {
+        int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+        int64_t tp = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+        __sgDequeBuf *a = __atomic_load_n(&d->buf, __ATOMIC_RELAXED);
+
+        if (b - tp > a->cap - 1)
+        {
+            __sgDequeBuf *grown = __sgDequeBufCreate(a->cap * 2);
+            if (!grown)
+                return SG_ERR_ALLOC;
+
+            for (int64_t i = tp; i < b; ++i)
+                grown->items[i & (grown->cap - 1)] = __atomic_load_n(&a->items[i & (a->cap - 1)], __ATOMIC_RELAXED);
+
+            grown->retired = a;
+            __atomic_store_n(&d->buf, grown, __ATOMIC_RELEASE);
+            a = grown;
+        }
+
+        __atomic_store_n(&a->items[b & (a->cap - 1)], t, __ATOMIC_RELAXED);
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELEASE);
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Pops a task from the bottom of the deque. Only the owner worker may call this.
+     * @param   d the deque
+     * @return  The task, or `NULL` if the deque is empty.
+     */
+    __sgTask *__sgDequePop(__sgDeque *d)
+    {
+        int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+        __sgDequeBuf *a = __atomic_load_n(&d->buf, __ATOMIC_RELAXED);
+        __atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        int64_t t = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+
+        __sgTask *x = NULL;
+        if (t <= b)
+        {
+            x = __atomic_load_n(&a->items[b & (a->cap - 1)], __ATOMIC_RELAXED);
+            if (t == b)
+            {
+                if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+                    x = NULL;
+                __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+            }
+        }
+        else
+            __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+
+        return x;
+    }
+
+    /*
+     * @brief   Steals a task from the top of the deque. Any thread may call this.
+     * @param   d the deque
+     * @return  The task, or `NULL` if the deque is empty or the steal lost a race.
+     */
+    __sgTask *__sgDequeSteal(__sgDeque *d)
+    {
+        int64_t t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+
+        if (t >= b)
+            return NULL;
+
+        __sgDequeBuf *a = __atomic_load_n(&d->buf, __ATOMIC_ACQUIRE);
+        __sgTask *x = __atomic_load_n(&a->items[t & (a->cap - 1)], __ATOMIC_RELAXED);
+        if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            return NULL;
+
+        return x;
+    }
+
+    /*
+     * @brief   Retrieves the approximate number of tasks inside the deque.
+     * @param   d the deque
+     * @return  The number of tasks.
+     */
+    int64_t __sgDequeSize(__sgDeque *d)
+    {
+        int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+        int64_t t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+        return (b > t) ? b - t : 0;
+    }
+
+    /*
+     * @brief   Releases the deque buffers, including the retired ones.
+     * @param   d the deque
+     * @return  None.
+     */
+    void __sgDequeDestroy(__sgDeque *d)
+    {
+        __sgDequeBuf *a = d->buf;
+        while (a != NULL)
+        {
+            __sgDequeBuf *prev = a->retired;
+            free(a->items);
+            free(a);
+            a = prev;
+        }
+        d->buf = NULL;
+    }
+
+    typedef struct __sgWorker
+    {
+        __sgDeque dq;
+        struct __sgSched *sched;
+        uint32_t idx;
+        uint64_t rng;
+        pthread_t thread;
+        uint8_t live;
+        uint8_t parked;
+        uint32_t wake;
+        struct __sgWorker *idleNext;
+        __sgCoCtx ctx;
+        __sgTask *cur;
+        __sgCoAction coAction;
+        pthread_mutex_t *parkUnlock;
+        uint64_t finished;
+        uint32_t node;
+        int cpu;
+        uint32_t tick;
+        uint8_t napped;
+        uint64_t runSeq;
+        uint8_t preempt;
+        uint64_t seenSeq;
+        int64_t seenAt;
+        __sgTask *runnext __attribute__((aligned(64)));
+        int64_t runnextAt;
+    } __sgWorker;
+
+    typedef struct __sgTimerEntry
+    {
+        int64_t when;
+        size_t idx;
+        void (*fire)(struct __sgTimerEntry *);
+    } __sgTimerEntry;
+
+    typedef struct
+    {
+        __sgMpsc q;
+        uint32_t token __attribute__((aligned(64)));
+        uint64_t len;
+    } __sgInject;
+
+    typedef struct
+    {
+        pthread_mutex_t lock __attribute__((aligned(64)));
+        __sgTask **items;
+        size_t n;
+        size_t cap;
+        uint64_t seq;
+        uint64_t len;
+        __sgTask *oldest;
+        __sgTask *newest;
+    } __sgPrioHeap;
+
+    typedef struct __sgSched
+    {
+        uint32_t nWorkers;
+        __sgWorker *workers;
+        uint32_t nLive;
+        uint32_t minLive;
+        uint8_t elastic;
+        int64_t idleTimeout;
+        pthread_mutex_t growLock;
+        __sgInject *inject;
+        uint32_t nNodes;
+        sgAffinity affinity;
+        sgCpuSet allowed;
+        uint32_t idle;
+        pthread_mutex_t idleLock;
+        __sgWorker *idleHead;
+        uint8_t stop;
+        uint8_t coroutine;
+        size_t stackSize;
+        pthread_mutex_t timerLock;
+        pthread_cond_t timerCond;
+        __sgTimerEntry **timers;
+        size_t nTimers;
+        size_t capTimers;
+        uint8_t timerStop;
+        pthread_t timerThread;
+        __sgSlab tasks;
+        uint64_t spawned;
+        __sgPrioHeap prio[__SG_PRIO_CLASSES];
+        int64_t aging;
+        uint8_t runNext;
+        int64_t slice;
+        uint8_t monitorIdle;
+        uint64_t preempted;
+        struct __sgSched *blocking;
+    } __sgSched;
+
+    __thread sgRoutineId __sgRoutineSelfTls = 0;
+
+    /*
+     * @brief   Takes a task slot from the scheduler's slab.
+     * @param   s the scheduler
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @return  The task, or `NULL` if failed.
+     */
+    __sgTask *__sgTaskAlloc(__sgSched *s, sgRoutine fn, void *arg)
+    {
+        uint64_t id;
+        __sgTask *t = (__sgTask *)__sgSlabAlloc(&s->tasks, &id);
+        if (!t)
+            return NULL;
+
+        t->fn = fn;
+        t->arg = arg;
+        t->node.next = NULL;
+        t->sched = s;
+        t->co = NULL;
+        t->state = __SG_TASK_RUNNING;
+        t->id = id;
+        t->prio = SG_PRIO_NORMAL;
+        t->deadline = INT64_MAX;
+        t->stackSize = 0;
+        t->arena = NULL;
+        return t;
+    }
+
+    /*
+     * @brief   Returns a task slot to the scheduler's slab.
+     * @param   t the task
+     * @return  None.
+     */
+    void __sgTaskFree(__sgTask *t)
+    {
+        __sgSlabFree(&t->sched->tasks, t);
+    }
+
+    __thread __sgWorker *__sgSchedWorkerTls = NULL;
+
+    /*
+     * @brief   Retrieves the worker running on the calling thread.
+     * @param   none
+     * @return  The worker, or `NULL` if the caller is not a scheduler worker.
+     */
+    __attribute__((noinline)) __sgWorker *__sgSchedCurrentWorker()
+    {
+        __asm__ __volatile__("" ::: "memory");
+        return __sgSchedWorkerTls;
+    }
+
+    void *__sgSchedWorkerRoutine(void *a);
+    uint8_t __sgSchedHasWork(__sgSched *s);
+
+    /*
+     * @brief   Starts a worker thread on a free slot of an elastic scheduler.
+     * @param   s the scheduler
+     * @return  `SG_NOTHING` if the scheduler is stopping or already runs its maximum number of workers. `SG_ERR_PTHREAD` if the thread could not be created. `SG_OK` if ok.
+     */
+    sgReturnType __sgSchedGrow(__sgSched *s)
+    {
+        sgReturnType ret = SG_NOTHING;
+
+        pthread_mutex_lock(&s->growLock);
+        if (!s->stop && s->nLive < s->nWorkers)
+        {
+            for (uint32_t i = 0; i < s->nWorkers; ++i)
+            {
+                __sgWorker *w = &s->workers[i];
+                if (w->live)
+                    continue;
+
+                w->live = 0x01;
+                if (pthread_create(&w->thread, NULL, __sgSchedWorkerRoutine, w) != 0)
+                {
+                    w->live = 0x00;
+                    ret = SG_ERR_PTHREAD;
+                    break;
+                }
+
+                __atomic_store_n(&s->nLive, s->nLive + 1, __ATOMIC_RELEASE);
+                ret = SG_OK;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&s->growLock);
+
+        return ret;
+    }
+
+    /*
+     * @brief   Retires an idle worker of an elastic scheduler, as long as more than the minimum number of workers are running.
+     * @param   w the worker
+     * @return  `1` if the worker must exit now. Otherwise, `0`.
+     * @note    A retired worker is detached and must not touch the scheduler after this returns.
+     */
+    uint8_t __sgSchedRetire(__sgWorker *w)
+    {
+        __sgSched *s = w->sched;
+        uint8_t retire = 0x00;
+
+        pthread_mutex_lock(&s->growLock);
+        if (!s->stop && s->nLive > s->minLive && !__sgSchedHasWork(s))
+        {
+            w->live = 0x00;
+            __atomic_store_n(&s->nLive, s->nLive - 1, __ATOMIC_RELEASE);
+            pthread_detach(pthread_self());
+            retire = 0x01;
+        }
+        pthread_mutex_unlock(&s->growLock);
+
+        return retire;
+    }
+
+    /*
+     * @brief   Claims up to `n` parked workers and wakes them, preferring the ones on a NUMA node. An elastic scheduler starts new workers instead when too few are parked.
+     * @param   s the scheduler
+     * @param   n the number of workers wanted
+     * @param   node the preferred node
+     * @return  None.
+     * @note    An elastic scheduler starts at most one new worker per online CPU per call.
+     */
+    void __sgSchedNotifyMany(__sgSched *s, uint64_t n, uint32_t node)
+    {
+        __sgWorker *claimed = NULL;
+        uint64_t woken = 0;
+
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&s->idle, __ATOMIC_SEQ_CST) > 0)
+        {
+            pthread_mutex_lock(&s->idleLock);
+            for (uint8_t local = (s->nNodes > 1) ? 0x01 : 0x00;; local = 0x00)
+            {
+                __sgWorker **pp = &s->idleHead;
+                while (woken < n && *pp != NULL)
+                {
+                    __sgWorker *w = *pp;
+                    if (local && w->node != node)
+                    {
+                        pp = &w->idleNext;
+                        continue;
+                    }
+
+                    *pp = w->idleNext;
+                    w->parked = 0x00;
+                    w->idleNext = claimed;
+                    claimed = w;
+                    __atomic_fetch_sub(&s->idle, 1, __ATOMIC_SEQ_CST);
+                    ++woken;
+                }
+
+                if (!local || woken == n)
+                    break;
+            }
+            pthread_mutex_unlock(&s->idleLock);
+
+            while (claimed != NULL)
+            {
+                __sgWorker *w = claimed;
+                claimed = w->idleNext;
+                __atomic_store_n(&w->wake, 1, __ATOMIC_RELEASE);
+                __sgFutexWake(&w->wake, 1);
+            }
+        }
+
+        if (!s->elastic || woken == n)
+            return;
+
+        uint64_t grow = n - woken;
+        if (grow > __sgNumCpus())
+            grow = __sgNumCpus();
+
+        while (grow-- > 0 && __atomic_load_n(&s->nLive, __ATOMIC_ACQUIRE) < s->nWorkers)
+            if (__sgSchedGrow(s) != SG_OK)
+                break;
+    }
+
+    /*
+     * @brief   Claims one parked worker, preferably on a NUMA node, and wakes it. An elastic scheduler starts a new worker instead when none is parked.
+     * @param   s the scheduler
+     * @param   node the preferred node
+     * @return  None.
+     */
+    void __sgSchedNotify(__sgSched *s, uint32_t node)
+    {
+        __sgSchedNotifyMany(s, 1, node);
+    }
+
+    /*
+     * @brief   Retrieves the NUMA node whose injection queue takes the calling thread's spawns.
+     * @param   s the scheduler
+     * @return  The node, always `0` unless the scheduler groups its workers by node.
+     */
+    uint32_t __sgSchedLocalNode(__sgSched *s)
+    {
+        if (s->nNodes == 1)
+            return 0;
+
+        uint32_t node = sgNumaCurrentNode();
+        return (node < s->nNodes) ? node : 0;
+    }
+
+    /*
+     * @brief   Pushes a task to the injection queue of a NUMA node without taking any lock.
+     * @param   s the scheduler
+     * @param   t the task
+     * @param   node the node
+     * @return  None.
+     */
+    void __sgSchedInjectPush(__sgSched *s, __sgTask *t, uint32_t node)
+    {
+        __atomic_fetch_add(&s->inject[node].len, 1, __ATOMIC_SEQ_CST);
+        __sgMpscPush(&s->inject[node].q, &t->node);
+    }
+
+    /*
+     * @brief   Pops a task from one injection queue. A worker also moves a share of the remaining tasks to its own deque, where idle workers can steal them.
+     * @param   s the scheduler
+     * @param   in the injection queue
+     * @param   w the calling worker, can be `NULL`
+     * @return  The task, or `NULL` if the queue is empty or another worker is draining it.
+     * @note    The queue has a single consumer at a time, the holder of its `token`.
+     */
+    __sgTask *__sgSchedInjectPopQueue(__sgSched *s, __sgInject *in, __sgWorker *w)
+    {
+        uint64_t len = __atomic_load_n(&in->len, __ATOMIC_ACQUIRE);
+        if (len == 0)
+            return NULL;
+
+        uint32_t token = 0;
+        if (!__atomic_compare_exchange_n(&in->token, &token, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return NULL;
+
+        __sgTask *first = NULL;
+        __sgMpscNode *n = __sgMpscPop(&in->q);
+        if (n != NULL)
+        {
+            first = (__sgTask *)((char *)n - offsetof(__sgTask, node));
+            __atomic_fetch_sub(&in->len, 1, __ATOMIC_SEQ_CST);
+
+            uint64_t share = (w == NULL) ? 0 : len / (__atomic_load_n(&s->nLive, __ATOMIC_ACQUIRE) + 1);
+            if (share > 128)
+                share = 128;
+
+            for (; share > 0 && (n = __sgMpscPop(&in->q)) != NULL; --share)
+            {
+                __sgTask *t = (__sgTask *)((char *)n - offsetof(__sgTask, node));
+                if (__sgDequePush(&w->dq, t) != SG_OK)
+                {
+                    __sgMpscPush(&in->q, n);
+                    break;
+                }
+                __atomic_fetch_sub(&in->len, 1, __ATOMIC_SEQ_CST);
+            }
+        }
+
+        __atomic_store_n(&in->token, 0, __ATOMIC_RELEASE);
+        return first;
+    }
+
+    /*
+     * @brief   Pops a task from the injection queues, starting with the one of the worker's NUMA node.
+     * @param   s the scheduler
+     * @param   w the calling worker, can be `NULL`
+     * @return  The task, or `NULL` if every queue is empty or being drained by another worker.
+     */
+    __sgTask *__sgSchedInjectPop(__sgSched *s, __sgWorker *w)
+    {
+        uint32_t start = (w == NULL) ? 0 : w->node;
+        for (uint32_t i = 0; i < s->nNodes; ++i)
+        {
+            __sgTask *t = __sgSchedInjectPopQueue(s, &s->inject[(start + i) % s->nNodes], w);
+            if (t != NULL)
+                return t;
+        }
+
+        return NULL;
+    }
+
+    /*
+     * @brief   Checks whether a task runs before another one of the same priority class: earliest deadline first, then first come.
+     * @param   a the first task
+     * @param   b the second task
+     * @return  `1` if `a` runs first. Otherwise, `0`.
+     */
+    uint8_t __sgPrioBefore(__sgTask *a, __sgTask *b)
+    {
+        return (a->deadline < b->deadline || (a->deadline == b->deadline && a->seq < b->seq)) ? 0x01 : 0x00;
+    }
+
+    /*
+     * @brief   Swaps two entries of a priority class heap.
+     * @param   hp the heap
+     * @param   i the first index
+     * @param   j the second index
+     * @return  None.
+     */
+    void __sgPrioHeapSwap(__sgPrioHeap *hp, size_t i, size_t j)
+    {
+        __sgTask *t = hp->items[i];
+        hp->items[i] = hp->items[j];
+        hp->items[j] = t;
+        hp->items[i]->heapIdx = i;
+        hp->items[j]->heapIdx = j;
+    }
+
+    /*
+     * @brief   Restores the priority class heap order around an index.
+     * @param   hp the heap
+     * @param   i the index
+     * @return  None.
+     */
+    void __sgPrioHeapFix(__sgPrioHeap *hp, size_t i)
+    {
+        while (i > 0 && __sgPrioBefore(hp->items[i], hp->items[(i - 1) / 2]))
+        {
+            __sgPrioHeapSwap(hp, i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+
+        while (1)
+        {
+            size_t l = 2 * i + 1, r = l + 1, m = i;
+            if (l < hp->n && __sgPrioBefore(hp->items[l], hp->items[m]))
+                m = l;
+            if (r < hp->n && __sgPrioBefore(hp->items[r], hp->items[m]))
+                m = r;
+            if (m == i)
+                break;
+            __sgPrioHeapSwap(hp, i, m);
+            i = m;
+        }
+    }
+
+    /*
+     * @brief   Pushes a task to the heap of its priority class.
+     * @param   hp the heap
+     * @param   t the task
+     * @return  `SG_ERR_ALLOC` if the heap failed to grow. `SG_OK` if ok.
+     * @note    Besides the heap order, tasks are linked from the oldest to the newest, so aging finds the task that has waited longest in O(1).
+     */
+    sgReturnType __sgPrioHeapPush(__sgPrioHeap *hp, __sgTask *t)
+    {
+        t->since = __sgMonoNanos();
+        pthread_mutex_lock(&hp->lock);
+
+        if (hp->n == hp->cap)
+        {
+            size_t cap = (hp->cap == 0) ? 64 : hp->cap * 2;
+            __sgTask **grown = (__sgTask **)realloc(hp->items, cap * sizeof(__sgTask *));
+            if (!grown)
+            {
+                pthread_mutex_unlock(&hp->lock);
+                return SG_ERR_ALLOC;
+            }
+            hp->items = grown;
+            hp->cap = cap;
+        }
+
+        t->seq = hp->seq++;
+        t->heapIdx = hp->n;
+        hp->items[hp->n++] = t;
+        __sgPrioHeapFix(hp, t->heapIdx);
+
+        t->younger = NULL;
+        t->older = hp->newest;
+        if (hp->newest == NULL)
+            hp->oldest = t;
+        else
+            hp->newest->younger = t;
+        hp->newest = t;
+
+        __atomic_store_n(&hp->len, hp->n, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&hp->lock);
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Pops the most urgent task from a priority class heap, or the one that has waited longest.
+     * @param   hp the heap
+     * @param   minWait pop the task queued longest if it has been queued for at least this long, `-1` to pop the most urgent one
+     * @return  The task, or `NULL` if the heap is empty or no task has waited long enough.
+     */
+    __sgTask *__sgPrioHeapPop(__sgPrioHeap *hp, int64_t minWait)
+    {
+        if (__atomic_load_n(&hp->len, __ATOMIC_ACQUIRE) == 0)
+            return NULL;
+
+        int64_t cutoff = (minWait >= 0) ? __sgMonoNanos() - minWait : INT64_MAX;
+
+        pthread_mutex_lock(&hp->lock);
+        if (hp->n == 0 || hp->oldest->since > cutoff)
+        {
+            pthread_mutex_unlock(&hp->lock);
+            return NULL;
+        }
+
+        __sgTask *t = (minWait >= 0) ? hp->oldest : hp->items[0];
+        size_t i = t->heapIdx;
+        if (i != --hp->n)
+        {
+            __sgPrioHeapSwap(hp, i, hp->n);
+            __sgPrioHeapFix(hp, i);
+        }
+
+        if (t->older == NULL)
+            hp->oldest = t->younger;
+        else
+            t->older->younger = t->younger;
+        if (t->younger == NULL)
+            hp->newest = t->older;
+        else
+            t->younger->older = t->older;
+
+        __atomic_store_n(&hp->len, hp->n, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&hp->lock);
+        return t;
+    }
+
+    /*
+     * @brief   Steals a task from another worker, starting from a random victim. Workers on the same NUMA node are tried first.
+     * @param   w the stealing worker
+     * @return  The task, or `NULL` if nothing could be stolen.
+     */
+    __sgTask *__sgSchedSteal(__sgWorker *w)
+    {
+        __sgSched *s = w->sched;
+        if (s->nWorkers < 2)
+            return NULL;
+
+        w->rng ^= w->rng << 13;
+        w->rng ^= w->rng >> 7;
+        w->rng ^= w->rng << 17;
+
+        uint32_t start = (uint32_t)(w->rng % s->nWorkers);
+        for (uint8_t pass = (s->nNodes > 1) ? 0 : 1; pass < 2; ++pass)
+        {
+            for (uint32_t i = 0; i < s->nWorkers; ++i)
+            {
+                __sgWorker *v = &s->workers[(start + i) % s->nWorkers];
+                if (v == w || (pass == 0 && v->node != w->node))
+                    continue;
+
+                __sgTask *t = __sgDequeSteal(&v->dq);
+                if (t != NULL)
+                    return t;
+            }
+        }
+
+        return NULL;
+    }
+
+    /*
+     * @brief   Takes the task in the worker's own run-next slot.
+     * @param   w the worker
+     * @return  The task, or `NULL` if the slot is empty.
+     */
+    __sgTask *__sgSchedTakeNext(__sgWorker *w)
+    {
+        if (__atomic_load_n(&w->runnext, __ATOMIC_RELAXED) == NULL)
+            return NULL;
+
+        return __atomic_exchange_n(&w->runnext, NULL, __ATOMIC_ACQ_REL);
+    }
+
+    /*
+     * @brief   Steals a task from the run-next slot of another worker, once it has waited there `__SG_RUNNEXT_GRACE` without its worker picking it up.
+     * @param   w the stealing worker
+     * @return  The task, or `NULL` if nothing could be stolen.
+     */
+    __sgTask *__sgSchedStealNext(__sgWorker *w)
+    {
+        __sgSched *s = w->sched;
+        if (!s->runNext || s->nWorkers < 2)
+            return NULL;
+
+        int64_t now = __sgMonoNanos();
+        for (uint32_t i = 1; i < s->nWorkers; ++i)
+        {
+            __sgWorker *v = &s->workers[(w->idx + i) % s->nWorkers];
+            __sgTask *t = __atomic_load_n(&v->runnext, __ATOMIC_ACQUIRE);
+            if (t == NULL || now - __atomic_load_n(&v->runnextAt, __ATOMIC_RELAXED) < __SG_RUNNEXT_GRACE)
+                continue;
+
+            if (__atomic_compare_exchange_n(&v->runnext, &t, NULL, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+                return t;
+        }
+
+        return NULL;
+    }
+
+    /*
+     * @brief   Checks whether any queue in the scheduler holds a task.
+     * @param   s the scheduler
+     * @return  `1` if there is pending work. Otherwise, `0`.
+     */
+    uint8_t __sgSchedHasWork(__sgSched *s)
+    {
+        for (uint32_t i = 0; i < s->nNodes; ++i)
+            if (__atomic_load_n(&s->inject[i].len, __ATOMIC_SEQ_CST) > 0)
+                return 0x01;
+
+        for (uint32_t i = 0; i < __SG_PRIO_CLASSES; ++i)
+            if (__atomic_load_n(&s->prio[i].len, __ATOMIC_SEQ_CST) > 0)
+                return 0x01;
+
+        for (uint32_t i = 0; i < s->nWorkers; ++i)
+            if (__sgDequeSize(&s->workers[i].dq) > 0)
+                return 0x01;
+
+        return 0x00;
+    }
+
+    /*
+     * @brief   Checks whether any run-next slot in the scheduler holds a task.
+     * @param   s the scheduler
+     * @return  `1` if one does. Otherwise, `0`.
+     */
+    uint8_t __sgSchedNextPending(__sgSched *s)
+    {
+        if (!s->runNext)
+            return 0x00;
+
+        for (uint32_t i = 0; i < s->nWorkers; ++i)
+            if (__atomic_load_n(&s->workers[i].runnext, __ATOMIC_SEQ_CST) != NULL)
+                return 0x01;
+
+        return 0x00;
+    }
+
+    /*
+     * @brief   Looks for the next task to run: lower-priority tasks that waited past the aging timeout, then realtime and deadline tasks, then own run-next slot, own deque, injection queue and stealing, then background tasks.
+     * @param   w the worker
+     * @return  The task, or `NULL` if there is none.
+     * @note    Every `__SG_PRIO_FAIRNESS`-th look skips the realtime and deadline tasks and the run-next slot, so a steady stream of them, or two routines handing a message back and forth, cannot starve plain routines.
+     */
+    __sgTask *__sgSchedFind(__sgWorker *w)
+    {
+        __sgSched *s = w->sched;
+        __sgTask *t;
+
+        if ((t = __sgPrioHeapPop(&s->prio[SG_PRIO_BACKGROUND], s->aging)) != NULL)
+            return t;
+        if ((t = __sgPrioHeapPop(&s->prio[SG_PRIO_NORMAL], s->aging)) != NULL)
+            return t;
+
+        uint8_t fair = (++w->tick % __SG_PRIO_FAIRNESS == 0) ? 0x01 : 0x00;
+        if (!fair)
+        {
+            if ((t = __sgPrioHeapPop(&s->prio[SG_PRIO_REALTIME], -1)) != NULL)
+                return t;
+            if ((t = __sgPrioHeapPop(&s->prio[SG_PRIO_NORMAL], -1)) != NULL)
+                return t;
+            if ((t = __sgSchedTakeNext(w)) != NULL)
+                return t;
+        }
+
+        if ((t = __sgDequePop(&w->dq)) != NULL)
+            return t;
+        if ((t = __sgSchedInjectPop(s, w)) != NULL)
+            return t;
+        if ((t = __sgSchedSteal(w)) != NULL)
+            return t;
+        if ((t = __sgSchedTakeNext(w)) != NULL)
+            return t;
+        if ((t = __sgSchedStealNext(w)) != NULL)
+            return t;
+
+        for (uint32_t c = fair ? SG_PRIO_REALTIME : SG_PRIO_BACKGROUND; c < __SG_PRIO_CLASSES; ++c)
+            if ((t = __sgPrioHeapPop(&s->prio[c], -1)) != NULL)
+                return t;
+
+        return NULL;
+    }
+
+    /*
+     * @brief   Parks the worker on the idle list until it is claimed by new work, or until the idle timeout passes on an elastic scheduler. While a run-next slot holds a task, it only naps for `__SG_RUNNEXT_GRACE`, to steal the task if its worker is still busy, once per claim so it does not poll the slots.
+     * @param   w the worker
+     * @return  `1` if the idle timeout passed without the worker being claimed. Otherwise, `0`.
+     */
+    uint8_t __sgSchedIdle(__sgWorker *w)
+    {
+        __sgSched *s = w->sched;
+        sgReturnType ret = SG_OK;
+
+        __atomic_store_n(&w->wake, 0, __ATOMIC_RELAXED);
+        pthread_mutex_lock(&s->idleLock);
+        w->idleNext = s->idleHead;
+        s->idleHead = w;
+        w->parked = 0x01;
+        __atomic_fetch_add(&s->idle, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&s->idleLock);
+
+        uint8_t nap = (!w->napped && __sgSchedNextPending(s)) ? 0x01 : 0x00;
+        if (!__sgSchedHasWork(s) && !__atomic_load_n(&s->stop, __ATOMIC_SEQ_CST))
+        {
+            while (ret == SG_OK && __atomic_load_n(&w->wake, __ATOMIC_ACQUIRE) == 0 && !__atomic_load_n(&s->stop, __ATOMIC_ACQUIRE))
+                ret = __sgFutexWait(&w->wake, 0, nap ? __SG_RUNNEXT_GRACE : (s->elastic ? s->idleTimeout : -1));
+        }
+
+        uint8_t claimed = 0x01;
+        pthread_mutex_lock(&s->idleLock);
+        if (w->parked)
+        {
+            __sgWorker **pp = &s->idleHead;
+            while (*pp != w)
+                pp = &(*pp)->idleNext;
+            *pp = w->idleNext;
+            w->parked = 0x00;
+            __atomic_fetch_sub(&s->idle, 1, __ATOMIC_SEQ_CST);
+            claimed = 0x00;
+        }
+        pthread_mutex_unlock(&s->idleLock);
+
+        if (claimed)
+            while (__atomic_load_n(&w->wake, __ATOMIC_ACQUIRE) == 0)
+                __sgFutexWait(&w->wake, 0, -1);
+
+        w->napped = (nap && !claimed) ? 0x01 : 0x00;
+        if (__atomic_load_n(&s->monitorIdle, __ATOMIC_SEQ_CST))
+        {
+            pthread_mutex_lock(&s->timerLock);
+            pthread_cond_signal(&s->timerCond);
+            pthread_mutex_unlock(&s->timerLock);
+        }
+        return (ret == SG_TIMEOUT && !claimed && !nap) ? 0x01 : 0x00;
+    }
+
+    /*
+     * @brief   Queues a runnable task: a task with a priority other than normal or a deadline to its class heap, other ones to the calling worker's deque if it belongs to the scheduler, otherwise to the injection queue of the caller's NUMA node.
+     * @param   s the scheduler
+     * @param   t the task
+     * @return  None.
+     */
+    void __sgSchedPush(__sgSched *s, __sgTask *t)
+    {
+        __sgWorker *w = __sgSchedCurrentWorker();
+        if (w != NULL && w->sched != s)
+            w = NULL;
+
+        if ((t->prio != SG_PRIO_NORMAL || t->deadline != INT64_MAX) && __sgPrioHeapPush(&s->prio[t->prio], t) == SG_OK)
+        {
+            __sgSchedNotify(s, (w != NULL) ? w->node : __sgSchedLocalNode(s));
+            return;
+        }
+
+        if (w != NULL && __sgDequePush(&w->dq, t) == SG_OK)
+        {
+            __sgSchedNotify(s, w->node);
+            return;
+        }
+
+        uint32_t node = __sgSchedLocalNode(s);
+        __sgSchedInjectPush(s, t, node);
+        __sgSchedNotify(s, node);
+    }
+
+    /*
+     * @brief   Queues a task woken by a routine: on a worker of the scheduler, a normal task goes to the worker's run-next slot so it runs right after the waker, while its message is still in cache. Other tasks are queued by `__sgSchedPush()`.
+     * @param   s the scheduler
+     * @param   t the task
+     * @return  None.
+     * @note    A task already in the slot is moved to the worker's deque. Other workers only take the slot once it has waited `__SG_RUNNEXT_GRACE`.
+     */
+    void __sgSchedPushNext(__sgSched *s, __sgTask *t)
+    {
+        __sgWorker *w = __sgSchedCurrentWorker();
+        if (!s->runNext || w == NULL || w->sched != s || t->prio != SG_PRIO_NORMAL || t->deadline != INT64_MAX)
+        {
+            __sgSchedPush(s, t);
+            return;
+        }
+
+        __atomic_store_n(&w->runnextAt, __sgMonoNanos(), __ATOMIC_RELAXED);
+        __sgTask *old = __atomic_exchange_n(&w->runnext, t, __ATOMIC_ACQ_REL);
+        if (old != NULL)
+            __sgSchedPush(s, old);
+        else
+            __sgSchedNotify(s, w->node);
+    }
+
+    /*
+     * @brief   Retrieves the task whose coroutine is running on the calling thread.
+     * @param   none
+     * @return  The task, or `NULL` if the caller is not running inside a coroutine.
+     */
+    __sgTask *__sgSchedCurrentTask()
+    {
+        __sgWorker *w = __sgSchedCurrentWorker();
+        return (w == NULL) ? NULL : w->cur;
+    }
+
+    /*
+     * @brief   The entry function of every routine coroutine.
+     * @param   a the task
+     * @return  None.
+     */
+    void __sgSchedCoEntry(void *a)
+    {
+        __sgTask *t = (__sgTask *)a;
+        t->fn(t->arg);
+
+        __sgWorker *w = __sgSchedCurrentWorker();
+        w->coAction = __SG_CO_FINISHED;
+        __sgCoSwitch(&t->co->ctx, &w->ctx);
+    }
+
+    /*
+     * @brief   Suspends the calling coroutine until `__sgSchedReady()` is called for its task.
+     * @param   unlock the mutex to unlock once the coroutine is suspended, can be `NULL`
+     * @return  None.
+     * @note    The caller must be running inside a coroutine. It may resume on a different worker.
+     */
+    void __sgSchedCoPark(pthread_mutex_t *unlock)
+    {
+        __sgWorker *w = __sgSchedCurrentWorker();
+        __sgTask *t = w->cur;
+
+        w->coAction = __SG_CO_PARKED;
+        w->parkUnlock = unlock;
+        __sgCoSwitch(&t->co->ctx, &w->ctx);
+    }
+
+    /*
+     * @brief   Suspends the calling coroutine and queues its task again behind the other runnable ones.
+     * @param   none
+     * @return  None.
+     * @note    The caller must be running inside a coroutine. It may resume on a different worker.
+     */
+    void __sgSchedCoYield()
+    {
+        __sgWorker *w = __sgSchedCurrentWorker();
+        __sgTask *t = w->cur;
+
+        w->coAction = __SG_CO_YIELDED;
+        __sgCoSwitch(&t->co->ctx, &w->ctx);
+    }
+
+    /*
+     * @brief   Yields the calling coroutine if the monitor asked its worker to, because its routine has run longer than the time slice.
+     * @param   none
+     * @return  `1` if it yielded. Otherwise, `0`.
+     */
+    uint8_t __sgSchedCheckpoint()
+    {
+        __sgWorker *w = __sgSchedCurrentWorker();
+        if (w == NULL || w->cur == NULL || !__atomic_load_n(&w->preempt, __ATOMIC_RELAXED))
+            return 0x00;
+
+        __sgSchedCoYield();
+        return 0x01;
+    }
+
+    /*
+     * @brief   Makes a parked task runnable again.
+     * @param   t the task
+     * @return  None.
+     * @note    If the task has not finished suspending yet, its worker requeues it right after.
+     */
+    void __sgSchedReady(__sgTask *t)
+    {
+        uint32_t st = __atomic_load_n(&t->state, __ATOMIC_ACQUIRE);
+        while (1)
+        {
+            if (st == __SG_TASK_PARKED)
+            {
+                if (__atomic_compare_exchange_n(&t->state, &st, __SG_TASK_RUNNING, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                {
+                    __sgSchedPushNext(t->sched, t);
+                    return;
+                }
+            }
+            else if (st == __SG_TASK_RUNNING)
+            {
+                if (__atomic_compare_exchange_n(&t->state, &st, __SG_TASK_NOTIFIED, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                    return;
+            }
+            else
+                return;
+        }
+    }
+
+    /*
+     * @brief   Runs a task on the calling worker, inside its coroutine in coroutine mode, and releases it once it finishes.
+     * @param   w the worker
+     * @param   t the task
+     * @return  None.
+     */
+    void __sgSchedRun(__sgWorker *w, __sgTask *t)
+    {
+        if (w->sched->coroutine && t->co == NULL)
+            t->co = __sgCoCreate((t->stackSize != 0) ? t->stackSize : w->sched->stackSize, __sgSchedCoEntry, t);
+
+        __sgRoutineSelfTls = t->id;
+
+        if (t->co == NULL)
+        {
+            t->fn(t->arg);
+            __sgRoutineSelfTls = 0;
+            __sgArenaRelease(__sgRoutineArenaTls);
+            __sgRoutineArenaTls = NULL;
+            __atomic_store_n(&w->finished, w->finished + 1, __ATOMIC_RELAXED);
+            __sgTaskFree(t);
+            return;
+        }
+
+        w->cur = t;
+        __atomic_store_n(&w->preempt, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&w->runSeq, w->runSeq + 1, __ATOMIC_RELAXED);
+        __sgCoSwitch(&w->ctx, &t->co->ctx);
+        __atomic_store_n(&w->runSeq, w->runSeq + 1, __ATOMIC_RELAXED);
+        w->cur = NULL;
+        __sgRoutineSelfTls = 0;
+
+        if (w->coAction == __SG_CO_FINISHED)
+        {
+            __atomic_store_n(&w->finished, w->finished + 1, __ATOMIC_RELAXED);
+            __sgCoDestroy(t->co);
+            __sgArenaRelease(t->arena);
+            __sgTaskFree(t);
+            return;
+        }
+
+        if (w->coAction == __SG_CO_YIELDED)
+        {
+            if (t->prio != SG_PRIO_NORMAL || t->deadline != INT64_MAX)
+                __sgSchedPush(w->sched, t);
+            else
+            {
+                __sgSchedInjectPush(w->sched, t, w->node);
+                __sgSchedNotify(w->sched, w->node);
+            }
+            return;
+        }
+
+        pthread_mutex_t *unlock = w->parkUnlock;
+        w->parkUnlock = NULL;
+        if (unlock != NULL)
+            pthread_mutex_unlock(unlock);
+
+        uint32_t st = __SG_TASK_RUNNING;
+        if (!__atomic_compare_exchange_n(&t->state, &st, __SG_TASK_PARKED, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            __atomic_store_n(&t->state, __SG_TASK_RUNNING, __ATOMIC_RELEASE);
+            __sgSchedPush(w->sched, t);
+        }
+    }
+
+    /*
+     * @brief   Swaps two entries of the timer heap.
+     * @param   s the scheduler
+     * @param   i the first index
+     * @param   j the second index
+     * @return  None.
+     */
+    void __sgSchedTimerSwap(__sgSched *s, size_t i, size_t j)
+    {
+        __sgTimerEntry *e = s->timers[i];
+        s->timers[i] = s->timers[j];
+        s->timers[j] = e;
+        s->timers[i]->idx = i;
+        s->timers[j]->idx = j;
+    }
+
+    /*
+     * @brief   Restores the timer heap order around an index.
+     * @param   s the scheduler
+     * @param   i the index
+     * @return  None.
+     */
+    void __sgSchedTimerFix(__sgSched *s, size_t i)
+    {
+        while (i > 0 && s->timers[(i - 1) / 2]->when > s->timers[i]->when)
+        {
+            __sgSchedTimerSwap(s, i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+
+        while (1)
+        {
+            size_t l = 2 * i + 1, r = l + 1, m = i;
+            if (l < s->nTimers && s->timers[l]->when < s->timers[m]->when)
+                m = l;
+            if (r < s->nTimers && s->timers[r]->when < s->timers[m]->when)
+                m = r;
+            if (m == i)
+                break;
+            __sgSchedTimerSwap(s, i, m);
+            i = m;
+        }
+    }
+
+    /*
+     * @brief   Arms a timer entry. Its `fire` callback runs on the timer thread, with the timer lock held, once `when` passes.
+     * @param   s the scheduler
+     * @param   e the timer entry, with `when` (monotonic nanoseconds) and `fire` set
+     * @return  `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     */
+    sgReturnType __sgSchedTimerAdd(__sgSched *s, __sgTimerEntry *e)
+    {
+        pthread_mutex_lock(&s->timerLock);
+
+        if (s->nTimers == s->capTimers)
+        {
+            size_t cap = (s->capTimers == 0) ? 64 : s->capTimers * 2;
+            __sgTimerEntry **grown = (__sgTimerEntry **)realloc(s->timers, cap * sizeof(__sgTimerEntry *));
+            if (!grown)
+            {
+                pthread_mutex_unlock(&s->timerLock);
+                return SG_ERR_ALLOC;
+            }
+            s->timers = grown;
+            s->capTimers = cap;
+        }
+
+        e->idx = s->nTimers;
+        s->timers[s->nTimers++] = e;
+        __sgSchedTimerFix(s, e->idx);
+
+        if (e->idx == 0)
+            pthread_cond_signal(&s->timerCond);
+
+        pthread_mutex_unlock(&s->timerLock);
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Disarms a timer entry if it has not fired yet.
+     * @param   s the scheduler
+     * @param   e the timer entry
+     * @return  None.
+     */
+    void __sgSchedTimerDel(__sgSched *s, __sgTimerEntry *e)
+    {
+        pthread_mutex_lock(&s->timerLock);
+
+        if (e->idx != SIZE_MAX)
+        {
+            size_t i = e->idx;
+            s->nTimers -= 1;
+            if (i != s->nTimers)
+            {
+                __sgSchedTimerSwap(s, i, s->nTimers);
+                __sgSchedTimerFix(s, i);
+            }
+            e->idx = SIZE_MAX;
+        }
+
+        pthread_mutex_unlock(&s->timerLock);
+    }
+
+    /*
+     * @brief   Asks every worker whose routine has run for a whole time slice to yield it at its next checkpoint, and wakes an idle worker to take over the rest of its queue.
+     * @param   s the scheduler
+     * @param   now the current time
+     * @return  None.
+     * @note    Only the timer thread calls this. A routine is told apart from the next one by the worker's run counter, which is odd while a routine runs.
+     */
+    void __sgSchedPreemptScan(__sgSched *s, int64_t now)
+    {
+        for (uint32_t i = 0; i < s->nWorkers; ++i)
+        {
+            __sgWorker *w = &s->workers[i];
+            uint64_t seq = __atomic_load_n(&w->runSeq, __ATOMIC_RELAXED);
+            if ((seq & 1) == 0 || seq != w->seenSeq)
+            {
+                w->seenSeq = seq;
+                w->seenAt = now;
+                continue;
+            }
+
+            if (now - w->seenAt >= s->slice && !__atomic_load_n(&w->preempt, __ATOMIC_RELAXED))
+            {
+                __atomic_store_n(&w->preempt, 1, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&s->preempted, 1, __ATOMIC_RELAXED);
+                __sgSchedNotify(s, w->node);
+            }
+        }
+    }
+
+    /*
+     * @brief   The timer thread, which fires the armed timer entries in deadline order, and every half time slice looks for routines to preempt while any worker is busy.
+     * @param   a the scheduler
+     * @return  A void pointer.
+     */
+    void *__sgSchedTimerRoutine(void *a)
+    {
+        __sgSched *s = (__sgSched *)a;
+        int64_t scan = 0;
+
+        pthread_mutex_lock(&s->timerLock);
+        while (!s->timerStop)
+        {
+            int64_t now = __sgMonoNanos();
+            __sgTimerEntry *e = (s->nTimers > 0) ? s->timers[0] : NULL;
+            if (e != NULL && e->when <= now)
+            {
+                s->nTimers -= 1;
+                if (s->nTimers > 0)
+                {
+                    __sgSchedTimerSwap(s, 0, s->nTimers);
+                    __sgSchedTimerFix(s, 0);
+                }
+                e->idx = SIZE_MAX;
+                e->fire(e);
+                continue;
+            }
+
+            if (s->slice > 0 && now >= scan)
+            {
+                __sgSchedPreemptScan(s, now);
+                scan = now + s->slice / 2;
+            }
+
+            int64_t until = (e != NULL) ? e->when : INT64_MAX;
+            if (s->slice > 0 && scan < until)
+            {
+                __atomic_store_n(&s->monitorIdle, 1, __ATOMIC_SEQ_CST);
+                if (__atomic_load_n(&s->idle, __ATOMIC_SEQ_CST) < __atomic_load_n(&s->nLive, __ATOMIC_SEQ_CST))
+                {
+                    __atomic_store_n(&s->monitorIdle, 0, __ATOMIC_RELAXED);
+                    until = scan;
+                }
+            }
+
+            if (until == INT64_MAX)
+                pthread_cond_wait(&s->timerCond, &s->timerLock);
+            else
+            {
+                struct timespec ts = {
+                    .tv_sec = until / SG_TIME_S,
+                    .tv_nsec = until % SG_TIME_S};
+                pthread_cond_timedwait(&s->timerCond, &s->timerLock, &ts);
+            }
+            __atomic_store_n(&s->monitorIdle, 0, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_unlock(&s->timerLock);
+
+        return NULL;
+    }
+
+    /*
+     * @brief   The main loop of a scheduler worker thread.
+     * @param   a the worker
+     * @return  A void pointer.
+     */
+    void *__sgSchedWorkerRoutine(void *a)
+    {
+        __sgWorker *w = (__sgWorker *)a;
+        __sgSchedWorkerTls = w;
+
+        if (w->sched->affinity != SG_AFFINITY_NONE)
+        {
+            sgCpuSet mask;
+            if (w->sched->affinity == SG_AFFINITY_CPU)
+            {
+                sgCpuSetClear(&mask);
+                sgCpuSetAdd(&mask, w->cpu);
+            }
+            else
+                __sgNumaNodeMask(w->node, &w->sched->allowed, &mask);
+            __sgCpuSetApplySelf(&mask);
+        }
+
+        while (!__atomic_load_n(&w->sched->stop, __ATOMIC_ACQUIRE))
+        {
+            __sgTask *t = __sgSchedFind(w);
+            if (t != NULL)
+                __sgSchedRun(w, t);
+            else if (__sgSchedIdle(w) && __sgSchedRetire(w))
+                break;
+        }
+
+        sgArenaDestroy(__sgArenaSpare);
+        __sgArenaSpare = NULL;
+        __sgSchedWorkerTls = NULL;
+        return NULL;
+    }
+
+    /*
+     * @brief   Wakes every worker and joins the running ones.
+     * @param   s the scheduler
+     * @return  None.
+     */
+    void __sgSchedStopWorkers(__sgSched *s)
+    {
+        pthread_mutex_lock(&s->growLock);
+        __atomic_store_n(&s->stop, 0x01, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&s->growLock);
+
+        for (uint32_t i = 0; i < s->nWorkers; ++i)
+        {
+            __atomic_store_n(&s->workers[i].wake, 1, __ATOMIC_RELEASE);
+            __sgFutexWake(&s->workers[i].wake, 1);
+        }
+
+        for (uint32_t i = 0; i < s->nWorkers; ++i)
+            if (s->workers[i].live)
+                pthread_join(s->workers[i].thread, NULL);
+    }
+
+    /*
+     * @brief   Stops the timer thread.
+     * @param   s the scheduler
+     * @return  None.
+     */
+    void __sgSchedStopTimer(__sgSched *s)
+    {
+        pthread_mutex_lock(&s->timerLock);
+        s->timerStop = 0x01;
+        pthread_cond_signal(&s->timerCond);
+        pthread_mutex_unlock(&s->timerLock);
+        pthread_join(s->timerThread, NULL);
+    }
+
+    /*
+     * @brief   Releases the scheduler memory and the tasks left in its queues.
+     * @param   s the scheduler
+     * @return  None.
+     * @note    Coroutines that already started are not unmapped, since wait lists may still point into their stacks.
+     */
+    void __sgSchedFree(__sgSched *s)
+    {
+        __sgTask *t;
+
+        for (uint32_t i = 0; i < s->nWorkers; ++i)
+        {
+            if ((t = s->workers[i].runnext) != NULL && t->co == NULL)
+                __sgTaskFree(t);
+            while ((t = __sgDequePop(&s->workers[i].dq)) != NULL)
+                if (t->co == NULL)
+                    __sgTaskFree(t);
+            __sgDequeDestroy(&s->workers[i].dq);
+        }
+
+        if (s->inject != NULL)
+            while ((t = __sgSchedInjectPop(s, NULL)) != NULL)
+                if (t->co == NULL)
+                    __sgTaskFree(t);
+
+        for (uint32_t i = 0; i < __SG_PRIO_CLASSES; ++i)
+        {
+            while ((t = __sgPrioHeapPop(&s->prio[i], -1)) != NULL)
+                if (t->co == NULL)
+                    __sgTaskFree(t);
+            pthread_mutex_destroy(&s->prio[i].lock);
+            free(s->prio[i].items);
+        }
+
+        pthread_cond_destroy(&s->timerCond);
+        pthread_mutex_destroy(&s->timerLock);
+        pthread_mutex_destroy(&s->growLock);
+        pthread_mutex_destroy(&s->idleLock);
+        __sgSlabDestroy(&s->tasks);
+        free(s->timers);
+        free(s->workers);
+        free(s->inject);
+        free(s);
+    }
+
+    /*
+     * @brief   Creates a scheduler and starts its workers.
+     * @param   cfg the configuration, `workers` set to `0` means the number of online CPUs
+     * @return  The pointer to the scheduler instance, or `NULL` if failed.
+     * @note    In `SG_MODE_COROUTINE`, every routine runs on its own coroutine and a timer thread is started for timed waits.
+     * @note    In `SG_MODE_POOL`, the scheduler starts `minWorkers` workers and grows up to `maxWorkers` when no worker is idle. Workers idle for `idleTimeout` exit again.
+     * @note    With an affinity set, workers are spread over the allowed CPUs node by node, and each NUMA node gets its own injection queue.
+     */
+    __sgSched *__sgSchedCreate(const sgConfig *cfg)
+    {
+        uint32_t nWorkers = (cfg->workers == 0) ? __sgNumCpus() : cfg->workers;
+        uint32_t nStart = nWorkers;
+
+        if (cfg->mode == SG_MODE_POOL)
+        {
+            nWorkers = (cfg->maxWorkers == 0) ? 16 * __sgNumCpus() : cfg->maxWorkers;
+            nStart = (cfg->minWorkers > nWorkers) ? nWorkers : cfg->minWorkers;
+        }
+
+        __sgSched *s = (__sgSched *)__sgAlignedAlloc(64, sizeof(__sgSched));
+        if (!s)
+            return NULL;
+        memset(s, 0, sizeof(__sgSched));
+
+        s->affinity = cfg->affinity;
+        if (cfg->cpuSet != NULL)
+            s->allowed = *cfg->cpuSet;
+        else if (__sgCpuSetGetSelf(&s->allowed) != SG_OK)
+            for (int c = 0; c < SG_CPU_MAX; ++c)
+                sgCpuSetAdd(&s->allowed, c);
+
+        s->nNodes = (s->affinity == SG_AFFINITY_NONE) ? 1 : sgNumaNodes();
+        s->inject = (__sgInject *)__sgAlignedAlloc(64, sizeof(__sgInject) * s->nNodes);
+        if (!s->inject)
+        {
+            free(s);
+            return NULL;
+        }
+        for (uint32_t i = 0; i < s->nNodes; ++i)
+        {
+            __sgMpscInit(&s->inject[i].q);
+            s->inject[i].token = 0;
+            s->inject[i].len = 0;
+        }
+
+        s->workers = (__sgWorker *)__sgAlignedAlloc(64, sizeof(__sgWorker) * nWorkers);
+        if (!s->workers)
+        {
+            free(s->inject);
+            free(s);
+            return NULL;
+        }
+        memset(s->workers, 0, sizeof(__sgWorker) * nWorkers);
+
+        if (__sgSlabInit(&s->tasks, sizeof(__sgTask)) != SG_OK)
+        {
+            free(s->workers);
+            free(s->inject);
+            free(s);
+            return NULL;
+        }
+
+        int *cpus = NULL;
+        uint32_t nCpus = 0;
+        if (s->affinity != SG_AFFINITY_NONE)
+        {
+            cpus = (int *)malloc(sizeof(int) * SG_CPU_MAX);
+            if (cpus != NULL)
+                nCpus = __sgNumaCpuOrder(&s->allowed, cpus);
+        }
+
+        pthread_condattr_t ca;
+        pthread_condattr_init(&ca);
+        pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+        pthread_mutex_init(&s->growLock, NULL);
+        pthread_mutex_init(&s->idleLock, NULL);
+        pthread_mutex_init(&s->timerLock, NULL);
+        pthread_cond_init(&s->timerCond, &ca);
+        pthread_condattr_destroy(&ca);
+        for (uint32_t i = 0; i < __SG_PRIO_CLASSES; ++i)
+            pthread_mutex_init(&s->prio[i].lock, NULL);
+
+        s->coroutine = (cfg->mode == SG_MODE_COROUTINE) ? 0x01 : 0x00;
+        s->stackSize = cfg->stackSize;
+        s->elastic = (cfg->mode == SG_MODE_POOL) ? 0x01 : 0x00;
+        s->minLive = nStart;
+        s->idleTimeout = (cfg->idleTimeout <= 0) ? 10LL * SG_TIME_S : cfg->idleTimeout;
+        s->aging = (cfg->agingTimeout <= 0) ? 50LL * SG_TIME_MS : cfg->agingTimeout;
+        s->runNext = (s->coroutine && cfg->runNext) ? 0x01 : 0x00;
+        s->slice = (!s->coroutine || cfg->timeSlice < 0) ? 0 : ((cfg->timeSlice == 0) ? 10LL * SG_TIME_MS : cfg->timeSlice);
+
+        for (uint32_t i = 0; i < nWorkers; ++i)
+        {
+            __sgWorker *w = &s->workers[i];
+            w->sched = s;
+            w->idx = i;
+            w->rng = 0x9E3779B97F4A7C15ULL * (i + 1);
+            w->cpu = (nCpus > 0) ? cpus[i % nCpus] : -1;
+            w->node = (nCpus > 0 && s->nNodes > 1) ? __sgNumaNodeOfCpu(w->cpu) : 0;
+
+            if (__sgDequeInit(&w->dq, 256) != SG_OK)
+            {
+                free(cpus);
+                __sgSchedFree(s);
+                return NULL;
+            }
+            s->nWorkers = i + 1;
+        }
+        free(cpus);
+
+        if (s->coroutine && pthread_create(&s->timerThread, NULL, __sgSchedTimerRoutine, s) != 0)
+        {
+            __sgSchedFree(s);
+            return NULL;
+        }
+
+        for (uint32_t i = 0; i < nStart; ++i)
+        {
+            if (__sgSchedGrow(s) != SG_OK)
+            {
+                __sgSchedStopWorkers(s);
+                if (s->coroutine)
+                    __sgSchedStopTimer(s);
+                __sgSchedFree(s);
+                return NULL;
+            }
+        }
+
+        return s;
+    }
+
+    /*
+     * @brief   Retrieves the elastic pool that runs the blocking calls of a coroutine scheduler's routines, starting it on first use.
+     * @param   s the scheduler
+     * @return  The pool, or `NULL` if it could not be started.
+     * @note    The pool starts without workers, grows by one worker per blocking call that finds every worker busy, and shrinks after the idle timeout.
+     */
+    __sgSched *__sgSchedBlockingPool(__sgSched *s)
+    {
+        __sgSched *b = __atomic_load_n(&s->blocking, __ATOMIC_ACQUIRE);
+        if (b != NULL)
+            return b;
+
+        pthread_mutex_lock(&s->growLock);
+        b = s->blocking;
+        if (b == NULL && !s->stop)
+        {
+            sgConfig cfg = sgConfigDefault();
+            cfg.mode = SG_MODE_POOL;
+            cfg.minWorkers = 0;
+            b = __sgSchedCreate(&cfg);
+            __atomic_store_n(&s->blocking, b, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&s->growLock);
+
+        return b;
+    }
+
+    /*
+     * @brief   Hands the calling worker's queued routines over to other workers before it blocks: wakes a parked worker to steal them, or has an elastic scheduler start one.
+     * @param   w the calling worker
+     * @return  None.
+     */
+    void __sgSchedHandoff(__sgWorker *w)
+    {
+        if (__sgSchedHasWork(w->sched))
+            __sgSchedNotify(w->sched, w->node);
+    }
+
+    /*
+     * @brief   Schedules a routine on the scheduler's workers.
+     * @param   s the scheduler
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @return  `SG_ERR_NULLPTR` if one argument is a `NULL`. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     * @note    A routine spawned from a worker goes to that worker's deque, other spawns go to the injection queue of the spawner's NUMA node.
+     */
+    sgReturnType __sgSchedSubmit(__sgSched *s, sgRoutine fn, void *arg)
+    {
+        if (s == NULL || fn == NULL)
+            return SG_ERR_NULLPTR;
+
+        __sgTask *t = __sgTaskAlloc(s, fn, arg);
+        if (!t)
+            return SG_ERR_ALLOC;
+
+        __atomic_fetch_add(&s->spawned, 1, __ATOMIC_RELAXED);
+        __sgSchedPush(s, t);
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Schedules a routine with a priority class and a deadline on the scheduler's workers.
+     * @param   s the scheduler
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @param   attr the attributes
+     * @return  `SG_ERR_NULLPTR` if one argument is a `NULL`. `SG_ERR_INVALID` if the priority is unknown. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     * @note    Higher classes are always picked first, earliest deadline first within a class. A routine that already runs is never preempted.
+     */
+    sgReturnType __sgSchedSubmitAttr(__sgSched *s, sgRoutine fn, void *arg, const sgAttr *attr)
+    {
+        if (s == NULL || fn == NULL || attr == NULL)
+            return SG_ERR_NULLPTR;
+
+        if ((uint32_t)attr->priority >= __SG_PRIO_CLASSES)
+            return SG_ERR_INVALID;
+
+        __sgTask *t = __sgTaskAlloc(s, fn, arg);
+        if (!t)
+            return SG_ERR_ALLOC;
+
+        t->prio = (uint8_t)attr->priority;
+        t->stackSize = attr->stackSize;
+        if (attr->deadline >= 0)
+            t->deadline = __sgMonoNanos() + attr->deadline;
+
+        __atomic_fetch_add(&s->spawned, 1, __ATOMIC_RELAXED);
+        __sgSchedPush(s, t);
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Schedules a batch of routines with a single push to the injection queue and a single round of wake-ups.
+     * @param   s the scheduler
+     * @param   fns the routine functions, or `NULL` to run `fn` for every argument
+     * @param   fn the routine function used when `fns` is `NULL`
+     * @param   args the arguments to be passed to the routines, can be `NULL` to pass `NULL` to every routine
+     * @param   n the number of routines
+     * @return  `SG_ERR_NULLPTR` if a routine function is a `NULL`. `SG_ERR_ALLOC` if memory allocation is somehow failed, in which case no routine is scheduled. `SG_OK` if ok.
+     * @note    A batch spawned from a worker goes to that worker's deque, other batches go to the injection queue of the spawner's NUMA node. Woken workers spread it by stealing.
+     */
+    sgReturnType __sgSchedSubmitBatch(__sgSched *s, const sgRoutine *fns, sgRoutine fn, void *const *args, size_t n)
+    {
+        if (s == NULL || (fns == NULL && fn == NULL))
+            return SG_ERR_NULLPTR;
+
+        if (n == 0)
+            return SG_OK;
+
+        if (fns != NULL)
+            for (size_t i = 0; i < n; ++i)
+                if (fns[i] == NULL)
+                    return SG_ERR_NULLPTR;
+
+        __sgTask *first = NULL, *last = NULL;
+        for (size_t i = 0; i < n; ++i)
+        {
+            __sgTask *t = __sgTaskAlloc(s, (fns != NULL) ? fns[i] : fn, (args != NULL) ? args[i] : NULL);
+            if (!t)
+            {
+                while (first != NULL)
+                {
+                    __sgTask *next = (first == last) ? NULL : (__sgTask *)((char *)first->node.next - offsetof(__sgTask, node));
+                    __sgTaskFree(first);
+                    first = next;
+                }
+                return SG_ERR_ALLOC;
+            }
+
+            if (last == NULL)
+                first = t;
+            else
+                last->node.next = &t->node;
+            last = t;
+        }
+
+        __atomic_fetch_add(&s->spawned, n, __ATOMIC_RELAXED);
+
+        size_t rest = n;
+        __sgWorker *w = __sgSchedCurrentWorker();
+        if (w != NULL && w->sched == s)
+        {
+            while (first != NULL)
+            {
+                __sgTask *next = (first == last) ? NULL : (__sgTask *)((char *)first->node.next - offsetof(__sgTask, node));
+                if (__sgDequePush(&w->dq, first) != SG_OK)
+                    break;
+                first = next;
+                --rest;
+            }
+        }
+
+        uint32_t node = (rest == n) ? __sgSchedLocalNode(s) : w->node;
+        if (first != NULL)
+        {
+            __atomic_fetch_add(&s->inject[node].len, rest, __ATOMIC_SEQ_CST);
+            __sgMpscPushChain(&s->inject[node].q, &first->node, &last->node);
+        }
+
+        __sgSchedNotifyMany(s, n, node);
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Retrieves the number of routines that have returned, summed over the workers.
+     * @param   s the scheduler
+     * @return  The number of routines.
+     */
+    uint64_t __sgSchedFinished(__sgSched *s)
+    {
+        uint64_t n = 0;
+        for (uint32_t i = 0; i < s->nWorkers; ++i)
+            n += __atomic_load_n(&s->workers[i].finished, __ATOMIC_RELAXED);
+        return n;
+    }
+
+    /*
+     * @brief   Stops the workers and destroys the scheduler. Routines that have not started yet are discarded.
+     * @param   s the scheduler
+     * @return  None.
+     * @note    This waits for every running routine to return or park. Parked coroutines are never resumed.
+     */
+    void __sgSchedDestroy(__sgSched *s)
+    {
+        if (s == NULL)
+            return;
+
+        __sgSchedStopWorkers(s);
+        __sgSchedDestroy(s->blocking);
+        if (s->coroutine)
+            __sgSchedStopTimer(s);
+        __sgSchedFree(s);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -1,88 +1,1114 @@
 #ifndef __SEGO_H
 #define __SEGO_H
 
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+#include <sched.h>
 #include "enums.h"
+#include "alloc.h"
+#include "sync.h"
+#include "mpsc.h"
 #include "queue.h"
 #include "list.h"
 #include "channel.h"
 #include "context.h"
 #include "select.h"
 #include "moment.h"
+#include "numa.h"
+#include "config.h"
+#include "stack.h"
+#include "arena.h"
+#include "coroutine.h"
+#include "scheduler.h"
+#include "park.h"
+#include "waitgroup.h"
+#include "parallel.h"
+#include "future.h"
+#include "group.h"
+#include "blocking.h"
 #include "handler.h"
 #include "map.h"
 
     __sgHandler *sgh;
 
     /*
-     * @brief   Starts sego handler.
-     * @param   none
+     * @brief   Creates an independent sego runtime, with its own handler or workers, queues and stats.
+     * @param   cfg the configuration, `NULL` for `sgConfigDefault()`
+     * @return  The pointer to the runtime (`sgRuntime`) instance, or `NULL` if failed.
+     * @note    With `SG_MODE_MN`, routines are multiplexed onto a fixed set of work-stealing worker threads instead of getting a thread each.
+     * @note    With `SG_MODE_COROUTINE`, each routine additionally runs on its own coroutine, so blocking on a channel, a context, a select or `sgMomentSleep()` suspends only the routine.
+     * @note    With `SG_MODE_POOL`, routines are handed to a pool of parked worker threads that grows up to `maxWorkers` and shrinks back to `minWorkers` after `idleTimeout`.
+     */
+    sgRuntime *sgRuntimeCreate(const sgConfig *cfg)
+    {
+        sgConfig c = (cfg == NULL) ? sgConfigDefault() : *cfg;
+
+        __sgHandler *h = (__sgHandler *)__sgAlignedAlloc(64, sizeof(__sgHandler));
+        if (h == NULL)
+            return NULL;
+
+        h->mode = c.mode;
+        h->sched = NULL;
+        h->spawned = 0;
+        h->finished = 0;
+        h->draining = 0x00;
+        h->spawning = 0;
+
+        h->ctx = sgContextCreate();
+        if (h->ctx == NULL)
+        {
+            free(h);
+            return NULL;
+        }
+
+        if (__sgAdmitInit(&h->admit, c.maxRoutines, c.maxQueued) != SG_OK)
+        {
+            sgContextDestroy(h->ctx);
+            free(h);
+            return NULL;
+        }
+
+        if (c.mode != SG_MODE_THREAD)
+        {
+            h->sched = __sgSchedCreate(&c);
+            if (h->sched == NULL)
+            {
+                __sgAdmitDeinit(&h->admit);
+                sgContextDestroy(h->ctx);
+                free(h);
+                return NULL;
+            }
+            return h;
+        }
+
+        __sgMpscInit(&h->events);
+        h->evWake = 0;
+        h->evSleeping = 0;
+        h->closing = 0x00;
+        h->affinity = c.affinity;
+        h->cpus = NULL;
+        h->nCpus = 0;
+        h->nextCpu = 0;
+        h->stackSize = c.stackSize;
+
+        if (h->stackSize == 0)
+        {
+            pthread_attr_t attr;
+            pthread_attr_init(&attr);
+            pthread_attr_getstacksize(&attr, &h->stackSize);
+            pthread_attr_destroy(&attr);
+        }
+
+        if (c.cpuSet != NULL)
+            h->allowed = *c.cpuSet;
+        else if (__sgCpuSetGetSelf(&h->allowed) != SG_OK)
+            for (int i = 0; i < SG_CPU_MAX; ++i)
+                sgCpuSetAdd(&h->allowed, i);
+
+        if (c.affinity == SG_AFFINITY_CPU)
+        {
+            h->cpus = (int *)malloc(sizeof(int) * SG_CPU_MAX);
+            if (h->cpus == NULL)
+            {
+                __sgAdmitDeinit(&h->admit);
+                sgContextDestroy(h->ctx);
+                free(h);
+                return NULL;
+            }
+            h->nCpus = __sgNumaCpuOrder(&h->allowed, h->cpus);
+        }
+
+        if (__sgSlabInit(&h->table, sizeof(__sgRoutineWrapperArgs)) != SG_OK)
+        {
+            __sgAdmitDeinit(&h->admit);
+            sgContextDestroy(h->ctx);
+            free(h->cpus);
+            free(h);
+            return NULL;
+        }
+
+        if (pthread_create(&h->sgHandlerThread, NULL, __sgHandlerRoutine, (void *)h) != 0)
+        {
+            __sgSlabDestroy(&h->table);
+            __sgAdmitDeinit(&h->admit);
+            sgContextDestroy(h->ctx);
+            free(h->cpus);
+            free(h);
+            return NULL;
+        }
+
+        return h;
+    }
+
+    /*
+     * @brief   Stops a sego runtime and destroys it.
+     * @param   rt the runtime instance
      * @return  None.
+     * @note    In `SG_MODE_MN`, `SG_MODE_COROUTINE` and `SG_MODE_POOL`, this waits for the running routines to return or block and discards the ones that have not started yet.
+     * @note    In `SG_MODE_THREAD`, the routine threads still running are canceled. Use `sgRuntimeShutdown()` to let them return first.
      */
-    void sgInit()
+    void sgRuntimeDestroy(sgRuntime *rt)
     {
-        sgh = (__sgHandler *)malloc(sizeof(__sgHandler));
-        if (sgh == NULL)
+        if (rt == NULL)
+            return;
+
+        if (rt->sched != NULL)
         {
-            perror("Failed to allocate memory for Sego handler.");
-            exit(EXIT_FAILURE);
+            __sgSchedDestroy(rt->sched);
+            __sgAdmitDeinit(&rt->admit);
+            sgContextDestroy(rt->ctx);
+            free(rt);
+            return;
         }
 
-        sgh->startCh = sgChanMake(sizeof(__sgRoutineWrapperArgs), 4);
-        if (sgh->startCh == NULL)
+        __atomic_store_n(&rt->closing, 0x01, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&rt->evWake, 1, __ATOMIC_RELEASE);
+        __sgFutexWake(&rt->evWake, 1);
+        pthread_join(rt->sgHandlerThread, NULL);
+        __sgSlabDestroy(&rt->table);
+        __sgAdmitDeinit(&rt->admit);
+        sgContextDestroy(rt->ctx);
+        free(rt->cpus);
+        free(rt);
+    }
+
+    /*
+     * @brief   Retrieves the context of a sego runtime, raised once its shutdown begins.
+     * @param   rt the runtime instance
+     * @return  The pointer to the context (`sgContext`), or `NULL` if the runtime is a `NULL`.
+     * @note    Long-running routines should pass it to `sgChanOutContext()` or `sgSelectWithContext()`, or poll `sgContextGetFlag()`, so they return as soon as `sgRuntimeShutdown()` is called.
+     */
+    sgContext *sgRuntimeContext(sgRuntime *rt)
+    {
+        return (rt == NULL) ? NULL : rt->ctx;
+    }
+
+    /*
+     * @brief   Counts the routines of a runtime that have not returned yet, including the spawns still on their way in and those waiting for admission.
+     * @param   rt the runtime instance
+     * @return  The number of routines.
+     * @note    The finished count is read before the spawned one, so a routine spawned and finished in between cannot hide a running one.
+     */
+    uint64_t __sgRuntimePending(sgRuntime *rt)
+    {
+        uint64_t n = __atomic_load_n(&rt->spawning, __ATOMIC_ACQUIRE);
+
+        pthread_mutex_lock(&rt->admit.lock);
+        n += rt->admit.nQueued;
+        pthread_mutex_unlock(&rt->admit.lock);
+
+        uint64_t finished, spawned;
+        if (rt->sched != NULL)
         {
-            perror("Failed to allocate memory for Sego handler's start channel.");
-            free(sgh);
-            exit(EXIT_FAILURE);
+            finished = __sgSchedFinished(rt->sched);
+            spawned = __atomic_load_n(&rt->sched->spawned, __ATOMIC_ACQUIRE);
+        }
+        else
+        {
+            finished = __atomic_load_n(&rt->finished, __ATOMIC_ACQUIRE);
+            spawned = __atomic_load_n(&rt->spawned, __ATOMIC_ACQUIRE);
         }
 
-        sgh->stopCh = sgChanMake(sizeof(pthread_t), 4);
-        if (sgh->stopCh == NULL)
+        return n + ((spawned > finished) ? spawned - finished : 0);
+    }
+
+    /*
+     * @brief   Shuts a sego runtime down gracefully. It stops accepting spawns, raises the runtime context, waits for the routines to return, and destroys the runtime once they all did.
+     * @param   rt the runtime instance
+     * @param   timeout the timeout, `-1` for infinite wait
+     * @param   stragglers holds the number of routines still running or queued when the timeout expired, `0` on success, can be `NULL`
+     * @return  `SG_ERR_NULLPTR` if the runtime is a `NULL`. `SG_TIMEOUT` if timeout, in which case the runtime is left alive and keeps refusing spawns. `SG_OK` if ok, in which case the runtime is destroyed.
+     * @note    Spawns on a draining runtime return `SG_REJECTED`, or `NULL` for handles and futures. Routines already admitted still run, queued ones included, and so do the parallel loops of running routines.
+     * @note    After a timeout, call it again to keep waiting, or `sgRuntimeDestroy()` to give up on the stragglers. Never call it from a routine of the runtime itself, which would wait for its own return.
+     * @note    Multiply the timeout with the desired time unit, e.g. 500L * `SG_TIME_MS` for 500ms timeout duration.
+     */
+    sgReturnType sgRuntimeShutdown(sgRuntime *rt, int64_t timeout, uint64_t *stragglers)
+    {
+        if (rt == NULL)
+            return SG_ERR_NULLPTR;
+
+        __atomic_store_n(&rt->draining, 0x01, __ATOMIC_SEQ_CST);
+        sgContextRaise(rt->ctx);
+
+        int64_t deadline = (timeout >= 0) ? __sgMonoNanos() + timeout : -1;
+        int64_t backoff = 50LL * SG_TIME_US;
+        uint64_t n;
+        while ((n = __sgRuntimePending(rt)) != 0)
         {
-            perror("Failed to allocate memory for Sego handler's stop channel.");
-            sgChanDestroy(sgh->startCh);
-            free(sgh);
-            exit(EXIT_FAILURE);
+            int64_t remaining = -1;
+            if (deadline >= 0)
+            {
+                remaining = deadline - __sgMonoNanos();
+                if (remaining <= 0)
+                {
+                    if (stragglers != NULL)
+                        *stragglers = n;
+                    return SG_TIMEOUT;
+                }
+            }
+
+            sgMomentSleep((remaining >= 0 && remaining < backoff) ? remaining : backoff);
+            if (backoff < SG_TIME_MS)
+                backoff *= 2;
         }
 
-        sgh->closeCtx = sgContextCreate();
-        if (sgh->closeCtx == NULL)
+        if (stragglers != NULL)
+            *stragglers = 0;
+        sgRuntimeDestroy(rt);
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Retrieves the counters of a sego runtime.
+     * @param   rt the runtime instance
+     * @param   stats holds the counters
+     * @return  `SG_ERR_NULLPTR` if one argument is a `NULL`. `SG_OK` if ok.
+     * @note    `workers` is the number of live worker threads, `0` in `SG_MODE_THREAD`. `queued` is the number of spawns waiting for admission under `maxRoutines`, `queuedTotal` the number ever queued and `rejected` the number refused. The counters are read without stopping the runtime.
+     */
+    sgReturnType sgRuntimeGetStats(sgRuntime *rt, sgRuntimeStats *stats)
+    {
+        if (rt == NULL || stats == NULL)
+            return SG_ERR_NULLPTR;
+
+        stats->mode = rt->mode;
+        if (rt->sched != NULL)
         {
-            perror("Failed to allocate memory for Sego handler's close context.");
-            sgChanDestroy(sgh->startCh);
-            sgChanDestroy(sgh->stopCh);
-            free(sgh);
-            exit(EXIT_FAILURE);
+            stats->finished = __sgSchedFinished(rt->sched);
+            stats->spawned = __atomic_load_n(&rt->sched->spawned, __ATOMIC_RELAXED);
+            stats->workers = __atomic_load_n(&rt->sched->nLive, __ATOMIC_RELAXED);
+            stats->preempted = __atomic_load_n(&rt->sched->preempted, __ATOMIC_RELAXED);
+        }
+        else
+        {
+            stats->finished = __atomic_load_n(&rt->finished, __ATOMIC_RELAXED);
+            stats->spawned = __atomic_load_n(&rt->spawned, __ATOMIC_RELAXED);
+            stats->workers = 0;
+            stats->preempted = 0;
+        }
+
+        pthread_mutex_lock(&rt->admit.lock);
+        stats->queued = rt->admit.nQueued;
+        stats->queuedTotal = rt->admit.queuedTotal;
+        stats->rejected = rt->admit.rejected;
+        pthread_mutex_unlock(&rt->admit.lock);
+
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Starts a sego routine on a runtime right away, bypassing admission control.
+     * @param   rt the runtime instance
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @param   a the attributes
+     * @return  `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if the routine thread could not be created. `SG_OK` if ok.
+     */
+    sgReturnType __sgSegoStart(sgRuntime *rt, sgRoutine fn, void *arg, const sgAttr *a)
+    {
+        if (rt->sched != NULL)
+            return __sgSchedSubmitAttr(rt->sched, fn, arg, a);
+
+        __sgRoutineWrapperArgs *args = __sgHandlerAddRoutine(rt, fn, arg);
+        if (args == NULL)
+            return SG_ERR_ALLOC;
+
+        args->prio = (uint8_t)a->priority;
+        args->stackSize = a->stackSize;
+
+        sgReturnType ret = __sgHandlerStartRoutine(rt, args);
+        if (ret != SG_OK)
+        {
+            __sgHandlerRemoveRoutine(rt, args);
+            return ret;
+        }
+
+        __atomic_fetch_add(&rt->spawned, 1, __ATOMIC_RELAXED);
+        __sgHandlerPost(rt, &args->startEv);
+        return SG_OK;
+    }
+
+    void *__sgAdmitRoutine(void *p);
+
+    /*
+     * @brief   Frees the admission slot of a finished routine, starting queued spawns in its place.
+     * @param   rt the runtime instance
+     * @return  None.
+     * @note    A queued spawn that fails to start is counted as rejected, and the slot goes to the next one.
+     */
+    void __sgAdmitFinish(sgRuntime *rt)
+    {
+        __sgAdmitEntry *e;
+        while ((e = __sgAdmitRelease(&rt->admit)) != NULL)
+        {
+            if (__sgSegoStart(rt, __sgAdmitRoutine, (void *)e, &e->attr) == SG_OK)
+                return;
+
+            pthread_mutex_lock(&rt->admit.lock);
+            rt->admit.rejected += 1;
+            pthread_mutex_unlock(&rt->admit.lock);
+            free(e);
+        }
+    }
+
+    /*
+     * @brief   Runs an admitted routine and frees its admission slot once it returns.
+     * @param   p the admitted spawn
+     * @return  A void pointer.
+     */
+    void *__sgAdmitRoutine(void *p)
+    {
+        __sgAdmitEntry *e = (__sgAdmitEntry *)p;
+        sgRuntime *rt = (sgRuntime *)e->rt;
+
+        e->fn(e->arg);
+        free(e);
+
+        __sgAdmitFinish(rt);
+        return NULL;
+    }
+
+    /*
+     * @brief   Starts a sego routine on a runtime with `maxRoutines` set through its admission control.
+     * @param   rt the runtime instance
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @param   a the attributes
+     * @param   policy what to do when the runtime already runs `maxRoutines` routines
+     * @param   timeout the timeout of `__SG_ADMIT_BLOCK`, `-1` for infinite wait
+     * @return  `SG_REJECTED` if refused. `SG_TIMEOUT` if timeout. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if the routine thread could not be created. `SG_OK` if started or queued.
+     */
+    sgReturnType __sgSegoQueue(sgRuntime *rt, sgRoutine fn, void *arg, const sgAttr *a, __sgAdmitPolicy policy, int64_t timeout)
+    {
+        __sgAdmitEntry *e = (__sgAdmitEntry *)malloc(sizeof(__sgAdmitEntry));
+        if (!e)
+            return SG_ERR_ALLOC;
+
+        e->rt = (void *)rt;
+        e->fn = fn;
+        e->arg = arg;
+        e->attr = *a;
+
+        sgReturnType ret = __sgAdmitAcquire(&rt->admit, e, policy, timeout);
+        if (ret == SG_NOTHING)
+            return SG_OK;
+
+        if (ret == SG_OK)
+            ret = __sgSegoStart(rt, __sgAdmitRoutine, (void *)e, &e->attr);
+        else
+        {
+            free(e);
+            return ret;
+        }
+
+        if (ret != SG_OK)
+        {
+            free(e);
+            __sgAdmitFinish(rt);
+        }
+
+        return ret;
+    }
+
+    /*
+     * @brief   Starts a sego routine on a runtime through its admission control, unless the runtime is draining.
+     * @param   rt the runtime instance
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @param   a the attributes
+     * @param   policy what to do when the runtime already runs `maxRoutines` routines
+     * @param   timeout the timeout of `__SG_ADMIT_BLOCK`, `-1` for infinite wait
+     * @return  `SG_REJECTED` if refused or the runtime is draining. `SG_TIMEOUT` if timeout. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if the routine thread could not be created. `SG_OK` if started or queued.
+     */
+    sgReturnType __sgSegoAdmit(sgRuntime *rt, sgRoutine fn, void *arg, const sgAttr *a, __sgAdmitPolicy policy, int64_t timeout)
+    {
+        if (!__sgHandlerSpawnEnter(rt))
+            return SG_REJECTED;
+
+        sgReturnType ret = (rt->admit.max == 0) ? __sgSegoStart(rt, fn, arg, a) : __sgSegoQueue(rt, fn, arg, a, policy, timeout);
+        __sgHandlerSpawnLeave(rt);
+        return ret;
+    }
+
+    /*
+     * @brief   Starts a sego routine on a runtime.
+     * @param   rt the runtime instance
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @return  None.
+     * @note    In `SG_MODE_THREAD`, the routine thread is created by the caller right away. The handler only books it and joins it once it returns.
+     * @note    With `maxRoutines` set and reached, the routine waits in the admission queue, or is dropped if the queue is full. Use `segoTryOn()` or `segoBlockOn()` to learn the outcome.
+     * @note    The routine is dropped if the runtime is draining after `sgRuntimeShutdown()`.
+     */
+    void segoOn(sgRuntime *rt, sgRoutine fn, void *arg)
+    {
+        if (rt == NULL || fn == NULL)
+            return;
+
+        if (rt->admit.max != 0)
+        {
+            sgAttr a = sgAttrDefault();
+            __sgSegoAdmit(rt, fn, arg, &a, __SG_ADMIT_QUEUE, -1);
+            return;
+        }
+
+        if (!__sgHandlerSpawnEnter(rt))
+            return;
+
+        if (rt->sched != NULL)
+        {
+            __sgSchedSubmit(rt->sched, fn, arg);
+            __sgHandlerSpawnLeave(rt);
+            return;
+        }
+
+        __sgRoutineWrapperArgs *args = __sgHandlerAddRoutine(rt, fn, arg);
+        if (args != NULL && __sgHandlerStartRoutine(rt, args) == SG_OK)
+        {
+            __atomic_fetch_add(&rt->spawned, 1, __ATOMIC_RELAXED);
+            __sgHandlerPost(rt, &args->startEv);
+        }
+        else if (args != NULL)
+            __sgHandlerRemoveRoutine(rt, args);
+
+        __sgHandlerSpawnLeave(rt);
+    }
+
+    /*
+     * @brief   Starts a sego routine with a priority class, a deadline and a stack size on a runtime.
+     * @param   rt the runtime instance
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @param   attr the attributes, `NULL` for `sgAttrDefault()`
+     * @return  `SG_ERR_NULLPTR` if the runtime or the function is a `NULL`. `SG_ERR_INVALID` if the priority is unknown. `SG_REJECTED` if the admission queue is full or the runtime is draining. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if the routine thread could not be created. `SG_OK` if ok.
+     * @note    In `SG_MODE_MN`, `SG_MODE_COROUTINE` and `SG_MODE_POOL`, workers always pick realtime routines before normal ones and background ones last, earliest deadline first within a class. Routines waiting longer than the runtime's `agingTimeout` are picked ahead of higher classes, so none starves. Running routines are never preempted.
+     * @note    In `SG_MODE_THREAD`, every routine starts right away, so the priority only sets the nice value of the routine thread (raising it may be refused without privileges) and the deadline is ignored.
+     * @note    With `maxRoutines` set and reached, `SG_OK` may mean the routine is waiting in the admission queue.
+     */
+    sgReturnType segoWithAttrOn(sgRuntime *rt, sgRoutine fn, void *arg, const sgAttr *attr)
+    {
+        if (rt == NULL || fn == NULL)
+            return SG_ERR_NULLPTR;
+
+        sgAttr a = (attr == NULL) ? sgAttrDefault() : *attr;
+        if ((uint32_t)a.priority >= __SG_PRIO_CLASSES)
+            return SG_ERR_INVALID;
+
+        return __sgSegoAdmit(rt, fn, arg, &a, __SG_ADMIT_QUEUE, -1);
+    }
+
+    /*
+     * @brief   Starts a sego routine on a runtime only if it can run right away under the runtime's `maxRoutines`.
+     * @param   rt the runtime instance
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @return  `SG_ERR_NULLPTR` if the runtime or the function is a `NULL`. `SG_REJECTED` if the runtime already runs `maxRoutines` routines or is draining. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if the routine thread could not be created. `SG_OK` if ok.
+     */
+    sgReturnType segoTryOn(sgRuntime *rt, sgRoutine fn, void *arg)
+    {
+        if (rt == NULL || fn == NULL)
+            return SG_ERR_NULLPTR;
+
+        sgAttr a = sgAttrDefault();
+        return __sgSegoAdmit(rt, fn, arg, &a, __SG_ADMIT_TRY, -1);
+    }
+
+    /*
+     * @brief   Starts a sego routine on a runtime, waiting until it can run under the runtime's `maxRoutines`, with timeout.
+     * @param   rt the runtime instance
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @param   timeout the timeout, `-1` for infinite wait
+     * @return  `SG_ERR_NULLPTR` if the runtime or the function is a `NULL`. `SG_REJECTED` if the runtime is draining. `SG_TIMEOUT` if timeout. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if the routine thread could not be created. `SG_OK` if ok.
+     * @note    Queued spawns are started before blocked ones. Inside a coroutine, this suspends only the calling routine. On a worker of an M:N runtime, it holds the worker while it waits.
+     * @note    Multiply the timeout with the desired time unit, e.g. 500L * `SG_TIME_MS` for 500ms timeout duration.
+     */
+    sgReturnType segoBlockOn(sgRuntime *rt, sgRoutine fn, void *arg, int64_t timeout)
+    {
+        if (rt == NULL || fn == NULL)
+            return SG_ERR_NULLPTR;
+
+        sgAttr a = sgAttrDefault();
+        return __sgSegoAdmit(rt, fn, arg, &a, __SG_ADMIT_BLOCK, timeout);
+    }
+
+    /*
+     * @brief   Starts a batch of sego routine threads on a runtime in `SG_MODE_THREAD`, posting their start events to the handler at once.
+     * @param   rt the runtime instance
+     * @param   fns the routine functions, or `NULL` to run `fn` for every argument
+     * @param   fn the routine function used when `fns` is `NULL`
+     * @param   args the arguments to be passed to the routines, can be `NULL` to pass `NULL` to every routine
+     * @param   n the number of routines
+     * @return  `SG_ERR_NULLPTR` if a routine function is a `NULL`. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if a routine thread could not be created. `SG_OK` if ok.
+     */
+    sgReturnType __sgSegoStartBatch(sgRuntime *rt, const sgRoutine *fns, sgRoutine fn, void *const *args, size_t n)
+    {
+        if (fns == NULL && fn == NULL)
+            return SG_ERR_NULLPTR;
+
+        sgReturnType ret = SG_OK;
+        __sgRoutineEvent *first = NULL, *last = NULL;
+        uint64_t started = 0;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            sgRoutine f = (fns != NULL) ? fns[i] : fn;
+            if (f == NULL)
+            {
+                ret = SG_ERR_NULLPTR;
+                break;
+            }
+
+            __sgRoutineWrapperArgs *a = __sgHandlerAddRoutine(rt, f, (args != NULL) ? args[i] : NULL);
+            if (a == NULL)
+            {
+                ret = SG_ERR_ALLOC;
+                break;
+            }
+
+            ret = __sgHandlerStartRoutine(rt, a);
+            if (ret != SG_OK)
+            {
+                __sgHandlerRemoveRoutine(rt, a);
+                break;
+            }
+
+            a->startEv.node.next = NULL;
+            if (last == NULL)
+                first = &a->startEv;
+            else
+                last->node.next = &a->startEv.node;
+            last = &a->startEv;
+            ++started;
+        }
+
+        if (first != NULL)
+        {
+            __atomic_fetch_add(&rt->spawned, started, __ATOMIC_RELAXED);
+            __sgHandlerPostChain(rt, first, last);
+        }
+
+        return ret;
+    }
+
+    /*
+     * @brief   Starts a batch of sego routines on a runtime, with one routine per argument.
+     * @param   rt the runtime instance
+     * @param   fns the routine functions, or `NULL` to run `fn` for every argument
+     * @param   fn the routine function used when `fns` is `NULL`
+     * @param   args the arguments to be passed to the routines, can be `NULL` to pass `NULL` to every routine
+     * @param   n the number of routines
+     * @return  `SG_ERR_NULLPTR` if a routine function is a `NULL`. `SG_REJECTED` if the runtime is draining. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if a routine thread could not be created. `SG_OK` if ok.
+     */
+    sgReturnType __sgSegoBatch(sgRuntime *rt, const sgRoutine *fns, sgRoutine fn, void *const *args, size_t n)
+    {
+        if (rt == NULL)
+            return SG_ERR_NULLPTR;
+
+        if (rt->admit.max != 0)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                sgRoutine f = (fns != NULL) ? fns[i] : fn;
+                sgReturnType ret = segoWithAttrOn(rt, f, (args != NULL) ? args[i] : NULL, NULL);
+                if (ret != SG_OK)
+                    return ret;
+            }
+            return SG_OK;
+        }
+
+        if (!__sgHandlerSpawnEnter(rt))
+            return SG_REJECTED;
+
+        sgReturnType ret = (rt->sched != NULL) ? __sgSchedSubmitBatch(rt->sched, fns, fn, args, n) : __sgSegoStartBatch(rt, fns, fn, args, n);
+        __sgHandlerSpawnLeave(rt);
+        return ret;
+    }
+
+    /*
+     * @brief   Starts `n` sego routines on a runtime, running the same function, one per argument, with a single enqueue and a single round of wake-ups.
+     * @param   rt the runtime instance
+     * @param   fn the routine function
+     * @param   args the arguments to be passed to the routines, can be `NULL` to pass `NULL` to every routine
+     * @param   n the number of routines
+     * @return  `SG_ERR_NULLPTR` if the runtime or the function is a `NULL`. `SG_REJECTED` if the runtime is draining. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if a routine thread could not be created. `SG_OK` if ok.
+     * @note    In `SG_MODE_MN`, `SG_MODE_COROUTINE` and `SG_MODE_POOL`, either the whole batch is scheduled or none of it. In `SG_MODE_THREAD`, the routines started before an error keep running.
+     * @note    With `maxRoutines` set, the routines go through admission control one by one, and those admitted or queued before an error stay so.
+     */
+    sgReturnType segoBatchOn(sgRuntime *rt, sgRoutine fn, void *const *args, size_t n)
+    {
+        if (fn == NULL)
+            return SG_ERR_NULLPTR;
+
+        return __sgSegoBatch(rt, NULL, fn, args, n);
+    }
+
+    /*
+     * @brief   Starts `n` sego routines on a runtime, each with its own function and argument, with a single enqueue and a single round of wake-ups.
+     * @param   rt the runtime instance
+     * @param   fns the routine functions
+     * @param   args the arguments to be passed to the routines, can be `NULL` to pass `NULL` to every routine
+     * @param   n the number of routines
+     * @return  `SG_ERR_NULLPTR` if the runtime, `fns` or one of the functions is a `NULL`. `SG_REJECTED` if the runtime is draining. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if a routine thread could not be created. `SG_OK` if ok.
+     * @note    In `SG_MODE_MN`, `SG_MODE_COROUTINE` and `SG_MODE_POOL`, either the whole batch is scheduled or none of it. In `SG_MODE_THREAD`, the routines started before an error keep running.
+     * @note    With `maxRoutines` set, the routines go through admission control one by one, and those admitted or queued before an error stay so.
+     */
+    sgReturnType segoBatchFnsOn(sgRuntime *rt, const sgRoutine *fns, void *const *args, size_t n)
+    {
+        if (fns == NULL)
+            return SG_ERR_NULLPTR;
+
+        return __sgSegoBatch(rt, fns, NULL, args, n);
+    }
+
+    /*
+     * @brief   Starts a sego routine that can be joined on a runtime.
+     * @param   rt the runtime instance
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @return  The pointer to the routine handle (`sgHandle`), or `NULL` if the routine could not be started.
+     * @note    Every handle must be passed to `sgJoin()` exactly once, which releases it.
+     */
+    sgHandle *segoJoinableOn(sgRuntime *rt, sgRoutine fn, void *arg)
+    {
+        if (rt == NULL || fn == NULL)
+            return NULL;
+
+        sgHandle *h = (sgHandle *)malloc(sizeof(sgHandle));
+        if (!h)
+            return NULL;
+
+        if (__sgWaitGroupInit(&h->done) != SG_OK)
+        {
+            free(h);
+            return NULL;
+        }
+
+        h->fn = fn;
+        h->arg = arg;
+        h->result = NULL;
+        sgWaitGroupAdd(&h->done, 1);
+
+        void *a = (void *)h;
+        if (__sgSegoBatch(rt, NULL, __sgHandleRoutine, &a, 1) != SG_OK)
+        {
+            __sgWaitGroupDeinit(&h->done);
+            free(h);
+            return NULL;
+        }
+
+        return h;
+    }
+
+    /*
+     * @brief   Waits for a joinable sego routine to return and releases its handle.
+     * @param   h the routine handle
+     * @param   result holds the value returned by the routine, can be `NULL`
+     * @return  `SG_ERR_NULLPTR` if the handle is a `NULL`. `SG_OK` if ok.
+     * @note    Inside a coroutine, this suspends only the calling routine.
+     */
+    sgReturnType sgJoin(sgHandle *h, void **result)
+    {
+        if (h == NULL)
+            return SG_ERR_NULLPTR;
+
+        sgWaitGroupWait(&h->done);
+        if (result != NULL)
+            *result = h->result;
+
+        __sgWaitGroupDeinit(&h->done);
+        free(h);
+        return SG_OK;
+    }
+
+    /*
+     * @brief   The routine behind a future from `segoFutureOn()`.
+     * @param   a the future
+     * @return  A void pointer.
+     */
+    void *__sgFutureRoutine(void *a)
+    {
+        sgFuture *f = (sgFuture *)a;
+        __sgFutureComplete(f, f->fn(f->arg));
+        return NULL;
+    }
+
+    /*
+     * @brief   The routine behind a continuation registered on an already completed future.
+     * @param   a the continuation future
+     * @return  A void pointer.
+     */
+    void *__sgFutureThenRoutine(void *a)
+    {
+        sgFuture *g = (sgFuture *)a;
+        __sgFutureComplete(g, g->then(g->input, g->arg));
+        return NULL;
+    }
+
+    /*
+     * @brief   Starts a sego routine on a runtime, whose return value is delivered through a future.
+     * @param   rt the runtime instance
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @return  The pointer to the future (`sgFuture`), or `NULL` if the routine could not be started.
+     * @note    Every future must be passed to `sgFutureDestroy()` exactly once.
+     */
+    sgFuture *segoFutureOn(sgRuntime *rt, sgRoutine fn, void *arg)
+    {
+        if (rt == NULL || fn == NULL)
+            return NULL;
+
+        sgFuture *f = __sgFutureCreate(rt);
+        if (!f)
+            return NULL;
+
+        f->fn = fn;
+        f->arg = arg;
+
+        if (segoWithAttrOn(rt, __sgFutureRoutine, (void *)f, NULL) != SG_OK)
+        {
+            __sgFutureRelease(f);
+            __sgFutureRelease(f);
+            return NULL;
+        }
+
+        return f;
+    }
+
+    /*
+     * @brief   Chains a continuation to a future. The continuation gets the future's value, and its own return value completes the returned future.
+     * @param   f the future instance
+     * @param   fn the continuation function
+     * @param   arg the argument to be passed to the continuation
+     * @return  The pointer to the continuation's future (`sgFuture`), or `NULL` if failed.
+     * @note    If the future is still pending, the continuation runs right after it completes, on the same routine, so there is no extra hop through the scheduler. Otherwise, it is started as a routine on the future's runtime, or run by the caller if that fails.
+     * @note    Both futures must still be destroyed.
+     */
+    sgFuture *sgFutureThen(sgFuture *f, sgFutureFn fn, void *arg)
+    {
+        if (f == NULL || fn == NULL)
+            return NULL;
+
+        sgFuture *g = __sgFutureCreate(f->rt);
+        if (!g)
+            return NULL;
+
+        g->then = fn;
+        g->arg = arg;
+
+        if (!__sgFutureChain(f, g) && segoWithAttrOn((sgRuntime *)f->rt, __sgFutureThenRoutine, (void *)g, NULL) != SG_OK)
+            __sgFutureThenRoutine((void *)g);
+
+        return g;
+    }
+
+    /*
+     * @brief   Creates a task group whose children are started on a runtime. The group is canceled when a child returns a non-`NULL` error or `sgGroupCancel()` is called.
+     * @param   rt the runtime instance
+     * @return  The pointer to the group (`sgGroup`) instance, or `NULL` if failed.
+     */
+    sgGroup *sgGroupCreateOn(sgRuntime *rt)
+    {
+        if (rt == NULL)
+            return NULL;
+
+        return __sgGroupCreate(rt);
+    }
+
+    /*
+     * @brief   Starts a child routine in a task group. The child gets the group context and its argument, and returns `NULL` on success or an error of its choosing.
+     * @param   g the group instance
+     * @param   fn the child function
+     * @param   arg the argument to be passed to the child
+     * @return  `SG_ERR_NULLPTR` if the group or the function is a `NULL`. `SG_CANCELED` if the group is already canceled, in which case the child is not started. `SG_REJECTED` if the runtime is draining. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if the routine thread could not be created. `SG_OK` if ok.
+     */
+    sgReturnType sgGroupGo(sgGroup *g, sgGroupFn fn, void *arg)
+    {
+        if (g == NULL || fn == NULL)
+            return SG_ERR_NULLPTR;
+
+        if (sgContextGetFlag(g->ctx) == SG_CTX_RAISED)
+            return SG_CANCELED;
+
+        __sgGroupChild *c = (__sgGroupChild *)malloc(sizeof(__sgGroupChild));
+        if (!c)
+            return SG_ERR_ALLOC;
+
+        c->g = g;
+        c->fn = fn;
+        c->arg = arg;
+
+        sgWaitGroupAdd(&g->wg, 1);
+        sgReturnType ret = segoWithAttrOn((sgRuntime *)g->rt, __sgGroupChildRoutine, (void *)c, NULL);
+        if (ret != SG_OK)
+        {
+            free(c);
+            sgWaitGroupDone(&g->wg);
+        }
+
+        return ret;
+    }
+
+    /*
+     * @brief   Retrieves how many participants a parallel job on a runtime may have, caller included.
+     * @param   rt the runtime instance
+     * @return  The number of participants, at least `1`.
+     */
+    uint32_t __sgParallelWidth(sgRuntime *rt)
+    {
+        uint32_t n = __sgNumCpus();
+        if (rt->sched != NULL && rt->sched->nWorkers < n)
+            n = rt->sched->nWorkers;
+        else if (rt->sched == NULL && rt->nCpus > 0 && rt->nCpus < n)
+            n = rt->nCpus;
+
+        return (n == 0) ? 1 : n;
+    }
+
+    /*
+     * @brief   Runs a parallel for or a parallel reduce on a runtime, with the caller as the first participant.
+     * @param   rt the runtime instance
+     * @param   begin the first index
+     * @param   end the index past the last one
+     * @param   grain the number of indices run at once, `0` to pick one
+     * @param   forFn the range function of a parallel for, or `NULL`
+     * @param   reduceFn the range function of a parallel reduce, or `NULL`
+     * @param   combine the combine function of a parallel reduce, or `NULL`
+     * @param   arg the argument to be passed to the functions
+     * @param   result the reduction value, or `NULL` for a parallel for
+     * @param   size the size of the reduction value, `0` for a parallel for
+     * @return  `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     */
+    sgReturnType __sgParallelRun(sgRuntime *rt, int64_t begin, int64_t end, int64_t grain, sgRangeFn forFn, sgReduceFn reduceFn, sgCombineFn combine, void *arg, void *result, size_t size)
+    {
+        if (end <= begin)
+            return SG_OK;
+
+        uint32_t width = __sgParallelWidth(rt);
+        int64_t n = end - begin;
+        if (grain <= 0)
+        {
+            grain = n / (8 * (int64_t)width);
+            if (grain < 1)
+                grain = 1;
+        }
+
+        int64_t chunks = (n - 1) / grain + 1;
+        uint32_t nSlots = (chunks < (int64_t)width) ? (uint32_t)chunks : width;
+        if (nSlots == 1)
+        {
+            if (forFn != NULL)
+                forFn(begin, end, arg);
+            else
+                reduceFn(begin, end, result, arg);
+            return SG_OK;
         }
 
-        sgh->table = NULL;
+        __sgParallelJob *j = __sgParallelJobCreate(begin, end, grain, nSlots, size, result);
+        if (!j)
+            return SG_ERR_ALLOC;
+
+        j->forFn = forFn;
+        j->reduceFn = reduceFn;
+        j->combine = combine;
+        j->arg = arg;
 
-        if (pthread_create(&sgh->sgHandlerThread, NULL, __sgHandlerRoutine, NULL) != 0)
+        uint32_t nHelpers = nSlots - 1;
+        __atomic_store_n(&j->refs, 1 + nHelpers, __ATOMIC_RELEASE);
+
+        if (rt->sched != NULL && rt->admit.max == 0)
         {
-            sgChanDestroy(sgh->startCh);
-            sgChanDestroy(sgh->stopCh);
-            sgContextDestroy(sgh->closeCtx);
-            free(sgh);
-            perror("Failed to start Sego handler routine.");
+            void **args = (void **)malloc(sizeof(void *) * nHelpers);
+            for (uint32_t i = 0; args != NULL && i < nHelpers; ++i)
+                args[i] = (void *)j;
+
+            if (args == NULL || __sgSegoBatch(rt, NULL, __sgParallelHelper, args, nHelpers) != SG_OK)
+                __atomic_fetch_sub(&j->refs, nHelpers, __ATOMIC_ACQ_REL);
+            free(args);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < nHelpers; ++i)
+                if (segoWithAttrOn(rt, __sgParallelHelper, (void *)j, NULL) != SG_OK)
+                    __atomic_fetch_sub(&j->refs, 1, __ATOMIC_ACQ_REL);
+        }
+
+        __sgParallelWork(j, 0);
+        sgWaitGroupWait(&j->done);
+        __sgParallelJobRelease(j);
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Runs a function over a range of indices in parallel on a runtime, and returns once every index has been run.
+     * @param   rt the runtime instance
+     * @param   begin the first index
+     * @param   end the index past the last one
+     * @param   grain the number of indices run at once, `0` to pick one from the range size and the number of workers
+     * @param   fn the range function, called with disjoint sub-ranges `[begin, end)`
+     * @param   arg the argument to be passed to the function
+     * @return  `SG_ERR_NULLPTR` if the runtime or the function is a `NULL`. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     * @note    The caller runs its share of the range instead of just waiting. Helper routines share the runtime's workers with other routines, and any participant that runs out of work steals half of the range left to another one, so uneven ranges still balance. Helpers are started like any other routine and count against `maxRoutines`; a helper that is not admitted in time leaves its share to the other participants. Inside a coroutine, the final wait suspends only the calling routine.
+     */
+    sgReturnType sgParallelForOn(sgRuntime *rt, int64_t begin, int64_t end, int64_t grain, sgRangeFn fn, void *arg)
+    {
+        if (rt == NULL || fn == NULL)
+            return SG_ERR_NULLPTR;
+
+        return __sgParallelRun(rt, begin, end, grain, fn, NULL, NULL, arg, NULL, 0);
+    }
+
+    /*
+     * @brief   Reduces a range of indices in parallel on a runtime.
+     * @param   rt the runtime instance
+     * @param   begin the first index
+     * @param   end the index past the last one
+     * @param   grain the number of indices run at once, `0` to pick one from the range size and the number of workers
+     * @param   fn the range function, folding a sub-range `[begin, end)` into a participant's own value `acc`
+     * @param   combine the combine function, folding a participant's value `other` into `acc`
+     * @param   arg the argument to be passed to the functions
+     * @param   result holds the identity on entry, which every participant's value starts from, and the reduced value on return
+     * @param   size the size of the reduction value
+     * @return  `SG_ERR_NULLPTR` if the runtime, a function or the result is a `NULL`. `SG_ERR_INVALID` if the size is `0`. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     * @note    Sub-ranges are folded and combined in no particular order, so both functions must be associative and commutative. See `sgParallelForOn()` for the scheduling.
+     */
+    sgReturnType sgParallelReduceOn(sgRuntime *rt, int64_t begin, int64_t end, int64_t grain, sgReduceFn fn, sgCombineFn combine, void *arg, void *result, size_t size)
+    {
+        if (rt == NULL || fn == NULL || combine == NULL || result == NULL)
+            return SG_ERR_NULLPTR;
+
+        if (size == 0)
+            return SG_ERR_INVALID;
+
+        return __sgParallelRun(rt, begin, end, grain, NULL, fn, combine, arg, result, size);
+    }
+
+    /*
+     * @brief   Retrieves the ID of the calling sego routine. IDs are built from a slot index and a generation, so the ID of an ended routine is not handed out again until its slot generation wraps around.
+     * @param   none
+     * @return  The routine ID, or `0` if the caller is not a sego routine.
+     * @note    IDs are only unique within one runtime.
+     */
+    __attribute__((noinline)) sgRoutineId sgSelf()
+    {
+        __asm__ __volatile__("" ::: "memory");
+        return __sgRoutineSelfTls;
+    }
+
+    /*
+     * @brief   Retrieves the arena of the calling sego routine, creating it on first use. Everything allocated from it is released at once when the routine returns.
+     * @param   none
+     * @return  The pointer to the arena (`sgArena`) instance, or `NULL` if the caller is not a sego routine or it could not be created.
+     * @note    Do not destroy it, nor keep its memory beyond the routine. Memory that must outlive the routine still needs `malloc()`.
+     */
+    __attribute__((noinline)) sgArena *sgRoutineArena()
+    {
+        __asm__ __volatile__("" ::: "memory");
+        if (__sgRoutineSelfTls == 0)
+            return NULL;
+
+        __sgTask *t = __sgSchedCurrentTask();
+        sgArena **slot = (t != NULL) ? &t->arena : &__sgRoutineArenaTls;
+        if (*slot == NULL)
+            *slot = (t != NULL || __sgSchedCurrentWorker() != NULL) ? __sgArenaAcquire() : sgArenaCreate(0);
+
+        return *slot;
+    }
+
+    /*
+     * @brief   Lets other routines run before the calling one continues.
+     * @param   none
+     * @return  None.
+     * @note    Inside a coroutine, the routine is queued again behind the runnable ones. Otherwise, the calling thread yields its CPU.
+     */
+    void sgYield()
+    {
+        if (__sgSchedCurrentTask() != NULL)
+            __sgSchedCoYield();
+        else
+            sched_yield();
+    }
+
+    /*
+     * @brief   Marks a point where the calling routine may be preempted. It yields only if the routine has run longer than the runtime's time slice.
+     * @param   none
+     * @return  `1` if it yielded. Otherwise, `0`.
+     * @note    Call it in the loops of CPU-bound routines in `SG_MODE_COROUTINE`, so they do not hold up the routines sharing their worker. It costs a few loads when there is nothing to do, and does nothing outside a coroutine.
+     */
+    uint8_t sgCheckpoint()
+    {
+        return __sgSchedCheckpoint();
+    }
+
+    /*
+     * @brief   Starts sego handler with a configuration, as the default runtime used by `sego()`.
+     * @param   cfg the configuration, `NULL` for `sgConfigDefault()`
+     * @return  None.
+     * @note    See `sgRuntimeCreate()` for the modes.
+     */
+    void sgInitWithConfig(const sgConfig *cfg)
+    {
+        sgh = sgRuntimeCreate(cfg);
+        if (sgh == NULL)
+        {
+            perror("Failed to start Sego handler.");
             exit(EXIT_FAILURE);
         }
     }
 
+    /*
+     * @brief   Starts sego handler.
+     * @param   none
+     * @return  None.
+     */
+    void sgInit()
+    {
+        sgInitWithConfig(NULL);
+    }
+
     /*
      * @brief   Stops sego handler.
      * @param   none
      * @return  None.
+     * @note    In `SG_MODE_MN`, `SG_MODE_COROUTINE` and `SG_MODE_POOL`, this waits for the running routines to return or block and discards the ones that have not started yet.
+     * @note    In `SG_MODE_THREAD`, the routine threads still running are canceled. Use `sgShutdown()` to let them return first.
      */
     void sgClose()
     {
-        uint8_t term = 0xFF;
-        sgContextRaise(sgh->closeCtx);
-        pthread_join(sgh->sgHandlerThread, NULL);
-        free(sgh);
+        sgRuntimeDestroy(sgh);
+        sgh = NULL;
+    }
+
+    /*
+     * @brief   Shuts sego handler down gracefully. It stops accepting spawns, raises the shutdown context, waits for the routines to return, and stops the handler once they all did.
+     * @param   timeout the timeout, `-1` for infinite wait
+     * @param   stragglers holds the number of routines still running or queued when the timeout expired, `0` on success, can be `NULL`
+     * @return  `SG_ERR_NULLPTR` if the handler is not started. `SG_TIMEOUT` if timeout, in which case the handler keeps running and refusing spawns. `SG_OK` if ok.
+     * @note    After a timeout, call it again to keep waiting, or `sgClose()` to give up on the stragglers.
+     * @note    Multiply the timeout with the desired time unit, e.g. 500L * `SG_TIME_MS` for 500ms timeout duration.
+     */
+    sgReturnType sgShutdown(int64_t timeout, uint64_t *stragglers)
+    {
+        sgReturnType ret = sgRuntimeShutdown(sgh, timeout, stragglers);
+        if (ret == SG_OK)
+            sgh = NULL;
+        return ret;
+    }
+
+    /*
+     * @brief   Retrieves the context of the default runtime, raised once `sgShutdown()` is called.
+     * @param   none
+     * @return  The pointer to the context (`sgContext`), or `NULL` if the handler is not started.
+     */
+    sgContext *sgShutdownContext()
+    {
+        return sgRuntimeContext(sgh);
     }
 
     /*
@@ -90,16 +1116,139 @@ extern "C"
      * @param   fn the routine function
      * @param   arg the argument to be passed to the routine
      * @return  None.
+     * @note    In `SG_MODE_THREAD`, the routine thread is created by the caller right away. The handler only books it and joins it once it returns.
      */
     void sego(sgRoutine fn, void *arg)
     {
-        if (fn == NULL)
-            return;
+        segoOn(sgh, fn, arg);
+    }
 
-        __sgRoutineWrapperArgs args;
-        args.fn = fn;
-        args.arg = arg;
-        sgChanIn(sgh->startCh, &args);
+    /*
+     * @brief   Starts a sego routine with a priority class, a deadline and a stack size.
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @param   attr the attributes, `NULL` for `sgAttrDefault()`
+     * @return  `SG_ERR_NULLPTR` if the function is a `NULL`. `SG_ERR_INVALID` if the priority is unknown. `SG_REJECTED` if the runtime is draining. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if the routine thread could not be created. `SG_OK` if ok.
+     */
+    sgReturnType segoWithAttr(sgRoutine fn, void *arg, const sgAttr *attr)
+    {
+        return segoWithAttrOn(sgh, fn, arg, attr);
+    }
+
+    /*
+     * @brief   Starts a sego routine only if it can run right away under the default runtime's `maxRoutines`.
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @return  `SG_ERR_NULLPTR` if the function is a `NULL`. `SG_REJECTED` if the runtime already runs `maxRoutines` routines or is draining. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if the routine thread could not be created. `SG_OK` if ok.
+     */
+    sgReturnType segoTry(sgRoutine fn, void *arg)
+    {
+        return segoTryOn(sgh, fn, arg);
+    }
+
+    /*
+     * @brief   Starts a sego routine, waiting until it can run under the default runtime's `maxRoutines`, with timeout.
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @param   timeout the timeout, `-1` for infinite wait
+     * @return  `SG_ERR_NULLPTR` if the function is a `NULL`. `SG_REJECTED` if the runtime is draining. `SG_TIMEOUT` if timeout. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if the routine thread could not be created. `SG_OK` if ok.
+     */
+    sgReturnType segoBlock(sgRoutine fn, void *arg, int64_t timeout)
+    {
+        return segoBlockOn(sgh, fn, arg, timeout);
+    }
+
+    /*
+     * @brief   Starts `n` sego routines running the same function, one per argument, with a single enqueue and a single round of wake-ups.
+     * @param   fn the routine function
+     * @param   args the arguments to be passed to the routines, can be `NULL` to pass `NULL` to every routine
+     * @param   n the number of routines
+     * @return  `SG_ERR_NULLPTR` if the function is a `NULL`. `SG_REJECTED` if the runtime is draining. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if a routine thread could not be created. `SG_OK` if ok.
+     * @note    In `SG_MODE_MN`, `SG_MODE_COROUTINE` and `SG_MODE_POOL`, either the whole batch is scheduled or none of it. In `SG_MODE_THREAD`, the routines started before an error keep running.
+     * @note    With `maxRoutines` set, the routines go through admission control one by one, and those admitted or queued before an error stay so.
+     */
+    sgReturnType segoBatch(sgRoutine fn, void *const *args, size_t n)
+    {
+        return segoBatchOn(sgh, fn, args, n);
+    }
+
+    /*
+     * @brief   Starts `n` sego routines, each with its own function and argument, with a single enqueue and a single round of wake-ups.
+     * @param   fns the routine functions
+     * @param   args the arguments to be passed to the routines, can be `NULL` to pass `NULL` to every routine
+     * @param   n the number of routines
+     * @return  `SG_ERR_NULLPTR` if `fns` or one of the functions is a `NULL`. `SG_REJECTED` if the runtime is draining. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_ERR_PTHREAD` if a routine thread could not be created. `SG_OK` if ok.
+     * @note    In `SG_MODE_MN`, `SG_MODE_COROUTINE` and `SG_MODE_POOL`, either the whole batch is scheduled or none of it. In `SG_MODE_THREAD`, the routines started before an error keep running.
+     * @note    With `maxRoutines` set, the routines go through admission control one by one, and those admitted or queued before an error stay so.
+     */
+    sgReturnType segoBatchFns(const sgRoutine *fns, void *const *args, size_t n)
+    {
+        return segoBatchFnsOn(sgh, fns, args, n);
+    }
+
+    /*
+     * @brief   Starts a sego routine that can be joined.
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @return  The pointer to the routine handle (`sgHandle`), or `NULL` if the routine could not be started.
+     * @note    Every handle must be passed to `sgJoin()` exactly once, which releases it.
+     */
+    sgHandle *segoJoinable(sgRoutine fn, void *arg)
+    {
+        return segoJoinableOn(sgh, fn, arg);
+    }
+
+    /*
+     * @brief   Starts a sego routine, whose return value is delivered through a future.
+     * @param   fn the routine function
+     * @param   arg the argument to be passed to the routine
+     * @return  The pointer to the future (`sgFuture`), or `NULL` if the routine could not be started.
+     * @note    Every future must be passed to `sgFutureDestroy()` exactly once.
+     */
+    sgFuture *segoFuture(sgRoutine fn, void *arg)
+    {
+        return segoFutureOn(sgh, fn, arg);
+    }
+
+    /*
+     * @brief   Creates a task group whose children are started on the default runtime.
+     * @param   none
+     * @return  The pointer to the group (`sgGroup`) instance, or `NULL` if failed.
+     */
+    sgGroup *sgGroupCreate()
+    {
+        return sgGroupCreateOn(sgh);
+    }
+
+    /*
+     * @brief   Runs a function over a range of indices in parallel, and returns once every index has been run.
+     * @param   begin the first index
+     * @param   end the index past the last one
+     * @param   grain the number of indices run at once, `0` to pick one from the range size and the number of workers
+     * @param   fn the range function, called with disjoint sub-ranges `[begin, end)`
+     * @param   arg the argument to be passed to the function
+     * @return  `SG_ERR_NULLPTR` if the function is a `NULL`. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     */
+    sgReturnType sgParallelFor(int64_t begin, int64_t end, int64_t grain, sgRangeFn fn, void *arg)
+    {
+        return sgParallelForOn(sgh, begin, end, grain, fn, arg);
+    }
+
+    /*
+     * @brief   Reduces a range of indices in parallel.
+     * @param   begin the first index
+     * @param   end the index past the last one
+     * @param   grain the number of indices run at once, `0` to pick one from the range size and the number of workers
+     * @param   fn the range function, folding a sub-range `[begin, end)` into a participant's own value `acc`
+     * @param   combine the combine function, folding a participant's value `other` into `acc`
+     * @param   arg the argument to be passed to the functions
+     * @param   result holds the identity on entry, and the reduced value on return
+     * @param   size the size of the reduction value
+     * @return  `SG_ERR_NULLPTR` if a function or the result is a `NULL`. `SG_ERR_INVALID` if the size is `0`. `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     */
+    sgReturnType sgParallelReduce(int64_t begin, int64_t end, int64_t grain, sgReduceFn fn, sgCombineFn combine, void *arg, void *result, size_t size)
+    {
+        return sgParallelReduceOn(sgh, begin, end, grain, fn, combine, arg, result, size);
     }
 
 #ifdef __cplusplus
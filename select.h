@@ -8,47 +8,121 @@ extern "C"
 
 #include <stdio.h>
 #include <stdarg.h>
-#include <poll.h>
 #include "context.h"
 #include "channel.h"
 
     typedef uint64_t sgSel;
 
+    /*
+     * @brief   Suspends the calling coroutine, or blocks the calling thread, until a context is raised or a channel holds data.
+     * @param   m number of contexts
+     * @param   ctx the contexts
+     * @param   n number of channels
+     * @param   ch the channels
+     * @return  The selected context/channel.
+     */
+    sgSel __sgSelectPark(int m, sgContext **ctx, int n, sgChan **ch)
+    {
+        __sgParker p;
+        __sgWaitLink links[m + n];
+        sgSel sel = (sgSel)NULL;
+        int reg = 0;
+
+        __sgParkerInit(&p);
+
+        for (; reg < m + n && sel == (sgSel)NULL; ++reg)
+        {
+            if (reg < m)
+            {
+                sgContext *c = ctx[reg];
+                pthread_mutex_lock(&c->lock);
+                if (c->flag == SG_CTX_RAISED)
+                    sel = (sgSel)c;
+                else
+                    __sgWaitListAdd(&c->waiters, &links[reg], &p, c);
+                pthread_mutex_unlock(&c->lock);
+            }
+            else
+            {
+                sgChan *c = ch[reg - m];
+                pthread_mutex_lock(&c->lock);
+                if (__sgChanSelectArm(c))
+                    sel = (sgSel)c;
+                else
+                    __sgWaitListAdd(&c->waiters, &links[reg], &p, c);
+                pthread_mutex_unlock(&c->lock);
+            }
+        }
+
+        if (sel == (sgSel)NULL)
+        {
+            __sgParkerWait(&p, NULL, -1);
+            sel = (sgSel)p.sel;
+        }
+        else
+            reg -= 1;
+
+        for (int i = 0; i < reg; ++i)
+        {
+            if (i < m)
+            {
+                pthread_mutex_lock(&ctx[i]->lock);
+                __sgWaitListRemove(&ctx[i]->waiters, &links[i]);
+                pthread_mutex_unlock(&ctx[i]->lock);
+            }
+            else
+            {
+                pthread_mutex_lock(&ch[i - m]->lock);
+                __sgWaitListRemove(&ch[i - m]->waiters, &links[i]);
+                __sgChanSelectDisarm(ch[i - m]);
+                pthread_mutex_unlock(&ch[i - m]->lock);
+            }
+        }
+
+        return sel;
+    }
+
+    /*
+     * @brief   Picks the first raised context or the first channel holding data, without waiting.
+     * @param   m number of contexts
+     * @param   ctx the contexts
+     * @param   n number of channels
+     * @param   ch the channels
+     * @return  The selected context/channel. Otherwise, `0`.
+     */
+    sgSel __sgSelectNow(int m, sgContext **ctx, int n, sgChan **ch)
+    {
+        for (int i = 0; i < m; ++i)
+            if (sgContextGetFlag(ctx[i]) == SG_CTX_RAISED)
+                return (sgSel)ctx[i];
+
+        for (int i = 0; i < n; ++i)
+            if (__sgChanReady(ch[i]))
+                return (sgSel)ch[i];
+
+        return (sgSel)NULL;
+    }
+
     /*
      * @brief   Select (listens) to several channels. This waits until a channel is receiving a data.
      * @param   n number of channels to be listened
      * @param   ... channels
      * @return  The successfully selected channel.
-     * @note    This function is blocking.
+     * @note    This function is blocking. Inside a coroutine, only the calling routine is suspended.
      */
     sgSel sgSelect(int n, ...)
     {
         sgChan *ch[n];
-        struct pollfd pfds[n];
 
         va_list args;
         va_start(args, n);
 
         for (int i = 0; i < n; ++i)
-        {
             ch[i] = va_arg(args, sgChan *);
-            pfds[i].fd = ch[i]->fd[0];
-            pfds[i].events = POLLIN;
-        }
 
         va_end(args);
 
-        int ret = poll(pfds, n, -1);
-        if (ret == -1)
-            return (sgSel)NULL;
-        else
-        {
-            for (int i = 0; i < n; ++i)
-            {
-                if (pfds[i].revents & POLLIN)
-                    return (sgSel)ch[i];
-            }
-        }
+        return __sgSelectPark(0, NULL, n, ch);
     }
 
     /*
@@ -62,31 +136,16 @@ extern "C"
     sgSel sgSelectDefault(int n, ...)
     {
         sgChan *ch[n];
-        struct pollfd pfds[n];
 
         va_list args;
         va_start(args, n);
 
         for (int i = 0; i < n; ++i)
-        {
             ch[i] = va_arg(args, sgChan *);
-            pfds[i].fd = ch[i]->fd[0];
-            pfds[i].events = POLLIN;
-        }
 
         va_end(args);
 
-        int ret = poll(pfds, n, 0);
-        if (ret <= 0)
-            return (sgSel)NULL;
-        else
-        {
-            for (int i = 0; i < n; ++i)
-            {
-                if (pfds[i].revents & POLLIN)
-                    return (sgSel)ch[i];
-            }
-        }
+        return __sgSelectNow(0, NULL, n, ch);
     }
 
     /*
@@ -95,50 +154,25 @@ extern "C"
      * @param   n number of channels to be listened
      * @param   ... contexes and channels (respectively)
      * @return  The successfully selected context/channel.
-     * @note    This function is blocking.
+     * @note    This function is blocking. Inside a coroutine, only the calling routine is suspended.
      */
     sgSel sgSelectWithContext(int m, int n, ...)
     {
         sgContext *ctx[m];
         sgChan *ch[n];
-        struct pollfd pfds[m + n];
 
         va_list args;
         va_start(args, n);
 
         for (int i = 0; i < m; ++i)
-        {
             ctx[i] = va_arg(args, sgContext *);
-            pfds[i].fd = ctx[i]->fd[0];
-            pfds[i].events = POLLIN;
-        }
 
         for (int i = 0; i < n; ++i)
-        {
             ch[i] = va_arg(args, sgChan *);
-            pfds[m + i].fd = ch[i]->fd[0];
-            pfds[m + i].events = POLLIN;
-        }
 
         va_end(args);
 
-        int ret = poll(pfds, m + n, -1);
-        if (ret == -1)
-            return (sgSel)NULL;
-        else
-        {
-            for (int i = 0; i < m; ++i)
-            {
-                if (pfds[i].revents & POLLIN)
-                    return (sgSel)ctx[i];
-            }
-
-            for (int i = 0; i < n; ++i)
-            {
-                if (pfds[m + i].revents & POLLIN)
-                    return (sgSel)ch[i];
-            }
-        }
+        return __sgSelectPark(m, ctx, n, ch);
     }
 
     /*
@@ -154,44 +188,19 @@ extern "C"
     {
         sgContext *ctx[m];
         sgChan *ch[n];
-        struct pollfd pfds[m + n];
 
         va_list args;
         va_start(args, n);
 
         for (int i = 0; i < m; ++i)
-        {
             ctx[i] = va_arg(args, sgContext *);
-            pfds[i].fd = ctx[i]->fd[0];
-            pfds[i].events = POLLIN;
-        }
 
         for (int i = 0; i < n; ++i)
-        {
             ch[i] = va_arg(args, sgChan *);
-            pfds[m + i].fd = ch[i]->fd[0];
-            pfds[m + i].events = POLLIN;
-        }
 
         va_end(args);
 
-        int ret = poll(pfds, m + n, 0);
-        if (ret <= 0)
-            return (sgSel)NULL;
-        else
-        {
-            for (int i = 0; i < m; ++i)
-            {
-                if (pfds[i].revents & POLLIN)
-                    return (sgSel)ctx[i];
-            }
-
-            for (int i = 0; i < n; ++i)
-            {
-                if (pfds[m + i].revents & POLLIN)
-                    return (sgSel)ch[i];
-            }
-        }
+        return __sgSelectNow(m, ctx, n, ch);
     }
 
 #ifdef __cplusplus
@@ -0,0 +1,248 @@
+#ifndef __SEGO_SLAB_H
+#define __SEGO_SLAB_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "enums.h"
+#include "alloc.h"
+
+#define SG_SLAB_CHUNK 1024U
+#define SG_SLAB_MAX_CHUNKS 4096U
+
+    typedef struct
+    {
+        uint32_t gen;
+        uint32_t index;
+        uint32_t nextFree;
+        uint32_t pad;
+    } __sgSlabHdr;
+
+    typedef struct
+    {
+        uint64_t freeHead __attribute__((aligned(64)));
+        size_t stride;
+        uint32_t nChunks;
+        char **chunks;
+        pthread_mutex_t growLock;
+    } __sgSlab;
+
+    /*
+     * @brief   Retrieves the header of a slot by its index.
+     * @param   sl the slab
+     * @param   index the slot index
+     * @return  The slot header.
+     */
+    __sgSlabHdr *__sgSlabSlot(__sgSlab *sl, uint32_t index)
+    {
+        char *chunk = __atomic_load_n(&sl->chunks[index / SG_SLAB_CHUNK], __ATOMIC_ACQUIRE);
+        return (__sgSlabHdr *)(chunk + (size_t)(index % SG_SLAB_CHUNK) * sl->stride);
+    }
+
+    /*
+     * @brief   Pushes a chain of free slots, linked from `first` to `last`, to the free list.
+     * @param   sl the slab
+     * @param   first the first slot index
+     * @param   last the last slot index
+     * @return  None.
+     */
+    void __sgSlabPushFree(__sgSlab *sl, uint32_t first, uint32_t last)
+    {
+        __sgSlabHdr *tail = __sgSlabSlot(sl, last);
+        uint64_t old = __atomic_load_n(&sl->freeHead, __ATOMIC_RELAXED);
+        uint64_t neu;
+
+        do
+        {
+            __atomic_store_n(&tail->nextFree, (uint32_t)old, __ATOMIC_RELAXED);
+            neu = (((old >> 32) + 1) << 32) | (uint64_t)(first + 1);
+        } while (!__atomic_compare_exchange_n(&sl->freeHead, &old, neu, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+
+    /*
+     * @brief   Adds a chunk of free slots to the slab.
+     * @param   sl the slab
+     * @return  `SG_ERR_ALLOC` if the slab is full or memory allocation is somehow failed. `SG_OK` if ok.
+     */
+    sgReturnType __sgSlabGrow(__sgSlab *sl)
+    {
+        pthread_mutex_lock(&sl->growLock);
+
+        if ((uint32_t)__atomic_load_n(&sl->freeHead, __ATOMIC_ACQUIRE) != 0)
+        {
+            pthread_mutex_unlock(&sl->growLock);
+            return SG_OK;
+        }
+
+        uint32_t c = sl->nChunks;
+        char *chunk = (c < SG_SLAB_MAX_CHUNKS) ? (char *)__sgAlignedAlloc(64, SG_SLAB_CHUNK * sl->stride) : NULL;
+        if (!chunk)
+        {
+            pthread_mutex_unlock(&sl->growLock);
+            return SG_ERR_ALLOC;
+        }
+
+        for (uint32_t i = 0; i < SG_SLAB_CHUNK; ++i)
+        {
+            __sgSlabHdr *h = (__sgSlabHdr *)(chunk + (size_t)i * sl->stride);
+            h->gen = 0;
+            h->index = c * SG_SLAB_CHUNK + i;
+            h->nextFree = h->index + 2;
+        }
+
+        __atomic_store_n(&sl->chunks[c], chunk, __ATOMIC_RELEASE);
+        __atomic_store_n(&sl->nChunks, c + 1, __ATOMIC_RELEASE);
+        __sgSlabPushFree(sl, c * SG_SLAB_CHUNK, c * SG_SLAB_CHUNK + SG_SLAB_CHUNK - 1);
+
+        pthread_mutex_unlock(&sl->growLock);
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Initializes a slab of fixed-size slots addressed by generational references, and preallocates its first chunk.
+     * @param   sl the slab
+     * @param   elemSize the size of a slot's payload
+     * @return  `SG_ERR_ALLOC` if memory allocation is somehow failed. `SG_OK` if ok.
+     */
+    sgReturnType __sgSlabInit(__sgSlab *sl, size_t elemSize)
+    {
+        sl->freeHead = 0;
+        sl->nChunks = 0;
+        sl->stride = (sizeof(__sgSlabHdr) + elemSize + 15) & ~(size_t)15;
+        sl->chunks = (char **)calloc(SG_SLAB_MAX_CHUNKS, sizeof(char *));
+        if (!sl->chunks)
+            return SG_ERR_ALLOC;
+
+        pthread_mutex_init(&sl->growLock, NULL);
+        if (__sgSlabGrow(sl) != SG_OK)
+        {
+            pthread_mutex_destroy(&sl->growLock);
+            free(sl->chunks);
+            return SG_ERR_ALLOC;
+        }
+
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Takes a free slot, without allocating unless every slot is in use. Any thread may call this.
+     * @param   sl the slab
+     * @param   ref holds the slot's reference (generation and index), can be `NULL`
+     * @return  The pointer to the slot's payload, or `NULL` if failed.
+     */
+    void *__sgSlabAlloc(__sgSlab *sl, uint64_t *ref)
+    {
+        uint64_t old = __atomic_load_n(&sl->freeHead, __ATOMIC_ACQUIRE);
+
+        while (1)
+        {
+            uint32_t top = (uint32_t)old;
+            if (top == 0)
+            {
+                if (__sgSlabGrow(sl) != SG_OK)
+                    return NULL;
+                old = __atomic_load_n(&sl->freeHead, __ATOMIC_ACQUIRE);
+                continue;
+            }
+
+            __sgSlabHdr *h = __sgSlabSlot(sl, top - 1);
+            uint64_t neu = (((old >> 32) + 1) << 32) | (uint64_t)__atomic_load_n(&h->nextFree, __ATOMIC_RELAXED);
+            if (__atomic_compare_exchange_n(&sl->freeHead, &old, neu, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+            {
+                uint32_t gen = h->gen + 1;
+                __atomic_store_n(&h->gen, gen, __ATOMIC_RELEASE);
+                if (ref != NULL)
+                    *ref = ((uint64_t)gen << 32) | h->index;
+                return (void *)(h + 1);
+            }
+        }
+    }
+
+    /*
+     * @brief   Returns a slot to the free list. References to it turn stale. Any thread may call this.
+     * @param   sl the slab
+     * @param   p the pointer to the slot's payload
+     * @return  None.
+     */
+    void __sgSlabFree(__sgSlab *sl, void *p)
+    {
+        __sgSlabHdr *h = (__sgSlabHdr *)p - 1;
+        __atomic_store_n(&h->gen, h->gen + 1, __ATOMIC_RELEASE);
+        __sgSlabPushFree(sl, h->index, h->index);
+    }
+
+    /*
+     * @brief   Retrieves the current reference of a slot in use.
+     * @param   p the pointer to the slot's payload
+     * @return  The reference. It is never `0`.
+     */
+    uint64_t __sgSlabRef(void *p)
+    {
+        __sgSlabHdr *h = (__sgSlabHdr *)p - 1;
+        return ((uint64_t)__atomic_load_n(&h->gen, __ATOMIC_ACQUIRE) << 32) | h->index;
+    }
+
+    /*
+     * @brief   Looks a slot up by reference.
+     * @param   sl the slab
+     * @param   ref the reference
+     * @return  The pointer to the slot's payload, or `NULL` if the reference is stale or invalid.
+     * @note    The payload of a slot that is freed concurrently stays readable, since chunks are only released with the slab.
+     */
+    void *__sgSlabGet(__sgSlab *sl, uint64_t ref)
+    {
+        uint32_t index = (uint32_t)ref;
+        uint32_t gen = (uint32_t)(ref >> 32);
+
+        if ((gen & 1) == 0 || index >= __atomic_load_n(&sl->nChunks, __ATOMIC_ACQUIRE) * SG_SLAB_CHUNK)
+            return NULL;
+
+        __sgSlabHdr *h = __sgSlabSlot(sl, index);
+        return (__atomic_load_n(&h->gen, __ATOMIC_ACQUIRE) == gen) ? (void *)(h + 1) : NULL;
+    }
+
+    /*
+     * @brief   Calls a function for every slot in use.
+     * @param   sl the slab
+     * @param   fn the function, taking the pointer to the slot's payload
+     * @return  None.
+     * @note    Slots taken or freed concurrently may or may not be visited.
+     */
+    void __sgSlabForEach(__sgSlab *sl, void (*fn)(void *))
+    {
+        uint32_t n = __atomic_load_n(&sl->nChunks, __ATOMIC_ACQUIRE) * SG_SLAB_CHUNK;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            __sgSlabHdr *h = __sgSlabSlot(sl, i);
+            if (__atomic_load_n(&h->gen, __ATOMIC_ACQUIRE) & 1)
+                fn((void *)(h + 1));
+        }
+    }
+
+    /*
+     * @brief   Releases every chunk of the slab.
+     * @param   sl the slab
+     * @return  None.
+     */
+    void __sgSlabDestroy(__sgSlab *sl)
+    {
+        for (uint32_t i = 0; i < sl->nChunks; ++i)
+            free(sl->chunks[i]);
+
+        free(sl->chunks);
+        pthread_mutex_destroy(&sl->growLock);
+        sl->chunks = NULL;
+        sl->nChunks = 0;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
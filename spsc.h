@@ -0,0 +1,148 @@
+#ifndef __SEGO_SPSC_H
+#define __SEGO_SPSC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "alloc.h"
+
+    typedef struct
+    {
+        size_t head __attribute__((aligned(64)));
+        size_t tailCache;
+        size_t tail __attribute__((aligned(64)));
+        size_t headCache;
+        uint32_t rxParked __attribute__((aligned(64)));
+        uint32_t txParked;
+        size_t mask __attribute__((aligned(64)));
+        size_t itemSize;
+        char *slots;
+    } __sgSpsc;
+
+    /*
+     * @brief   Creates a bounded lock-free single-producer single-consumer ring.
+     * @param   itemSize the size for each item
+     * @param   bufferSize the minimum number of items it holds, rounded up to a power of two
+     * @return  The pointer to the ring, or `NULL` if failed.
+     * @note    The indices of each side, and the flags telling a side that the other one is parked, live on cache lines of their own.
+     */
+    __sgSpsc *__sgSpscCreate(size_t itemSize, size_t bufferSize)
+    {
+        if (itemSize == 0 || bufferSize == 0 || bufferSize > SIZE_MAX / 2)
+            return NULL;
+
+        size_t cap = 1;
+        while (cap < bufferSize)
+            cap *= 2;
+
+        if (cap > SIZE_MAX / itemSize)
+            return NULL;
+
+        __sgSpsc *q = (__sgSpsc *)__sgAlignedAlloc(64, sizeof(__sgSpsc));
+        if (!q)
+            return NULL;
+
+        q->slots = (char *)malloc(cap * itemSize);
+        if (!q->slots)
+        {
+            free(q);
+            return NULL;
+        }
+
+        q->head = 0;
+        q->tailCache = 0;
+        q->tail = 0;
+        q->headCache = 0;
+        q->rxParked = 0;
+        q->txParked = 0;
+        q->mask = cap - 1;
+        q->itemSize = itemSize;
+        return q;
+    }
+
+    /*
+     * @brief   Destroys the ring.
+     * @param   q the ring
+     * @return  None.
+     */
+    void __sgSpscDestroy(__sgSpsc *q)
+    {
+        if (q == NULL)
+            return;
+
+        free(q->slots);
+        free(q);
+    }
+
+    /*
+     * @brief   Pushes an item unless the ring is full. Only the producer may call this.
+     * @param   q the ring
+     * @param   data the item
+     * @return  `1` if pushed. Otherwise, `0`.
+     */
+    uint8_t __sgSpscPush(__sgSpsc *q, const void *data)
+    {
+        size_t t = q->tail;
+        if (t - q->headCache > q->mask)
+        {
+            q->headCache = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+            if (t - q->headCache > q->mask)
+                return 0x00;
+        }
+
+        memcpy(q->slots + (t & q->mask) * q->itemSize, data, q->itemSize);
+        __atomic_store_n(&q->tail, t + 1, __ATOMIC_RELEASE);
+        return 0x01;
+    }
+
+    /*
+     * @brief   Pops an item unless the ring is empty. Only the consumer may call this.
+     * @param   q the ring
+     * @param   buf the buffer to hold the item
+     * @return  `1` if popped. Otherwise, `0`.
+     */
+    uint8_t __sgSpscPop(__sgSpsc *q, void *buf)
+    {
+        size_t h = q->head;
+        if (h == q->tailCache)
+        {
+            q->tailCache = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+            if (h == q->tailCache)
+                return 0x00;
+        }
+
+        memcpy(buf, q->slots + (h & q->mask) * q->itemSize, q->itemSize);
+        __atomic_store_n(&q->head, h + 1, __ATOMIC_RELEASE);
+        return 0x01;
+    }
+
+    /*
+     * @brief   Checks whether the ring holds an item. Any thread may call this.
+     * @param   q the ring
+     * @return  `1` if it does. Otherwise, `0`.
+     */
+    uint8_t __sgSpscReady(__sgSpsc *q)
+    {
+        return __atomic_load_n(&q->tail, __ATOMIC_SEQ_CST) != __atomic_load_n(&q->head, __ATOMIC_SEQ_CST);
+    }
+
+    /*
+     * @brief   Checks whether the ring has room for an item. Any thread may call this.
+     * @param   q the ring
+     * @return  `1` if it has. Otherwise, `0`.
+     */
+    uint8_t __sgSpscRoom(__sgSpsc *q)
+    {
+        return __atomic_load_n(&q->tail, __ATOMIC_SEQ_CST) - __atomic_load_n(&q->head, __ATOMIC_SEQ_CST) <= q->mask;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,237 @@
+#ifndef __SEGO_STACK_H
+#define __SEGO_STACK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "enums.h"
+
+#ifndef MAP_ANONYMOUS
+#ifdef MAP_ANON
+#define MAP_ANONYMOUS MAP_ANON
+#else
+#error "sego needs MAP_ANONYMOUS: define _DEFAULT_SOURCE (or _GNU_SOURCE), or include sego.h before any system header"
+#endif
+#endif
+
+#ifndef MAP_STACK
+#define MAP_STACK 0
+#endif
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+#define SG_STACK_MIN (16UL * 1024UL)
+#define SG_STACK_CLASSES 12U
+#define SG_STACK_CACHE_LIMIT (64UL * 1024UL * 1024UL)
+
+    typedef struct __sgStackFree
+    {
+        struct __sgStackFree *next;
+    } __sgStackFree;
+
+    typedef struct
+    {
+        pthread_mutex_t lock __attribute__((aligned(64)));
+        __sgStackFree *head;
+    } __sgStackClass;
+
+    typedef struct
+    {
+        __sgStackClass classes[SG_STACK_CLASSES];
+        size_t page;
+        size_t cached;
+        size_t limit;
+    } __sgStackPool;
+
+    __sgStackPool __sgStacks;
+    pthread_once_t __sgStacksOnce = PTHREAD_ONCE_INIT;
+
+    /*
+     * @brief   Initializes the process-wide stack pool.
+     * @param   none
+     * @return  None.
+     */
+    void __sgStackPoolInit()
+    {
+        for (uint32_t i = 0; i < SG_STACK_CLASSES; ++i)
+        {
+            pthread_mutex_init(&__sgStacks.classes[i].lock, NULL);
+            __sgStacks.classes[i].head = NULL;
+        }
+
+        __sgStacks.page = (size_t)sysconf(_SC_PAGESIZE);
+        __sgStacks.cached = 0;
+        __sgStacks.limit = SG_STACK_CACHE_LIMIT;
+    }
+
+    /*
+     * @brief   Retrieves the process-wide stack pool, initializing it on first use.
+     * @param   none
+     * @return  The pool.
+     */
+    __sgStackPool *__sgStackPoolGet()
+    {
+        pthread_once(&__sgStacksOnce, __sgStackPoolInit);
+        return &__sgStacks;
+    }
+
+    /*
+     * @brief   Retrieves the size class of a usable stack size. Class `k` holds stacks of `SG_STACK_MIN << k` bytes.
+     * @param   size the usable stack size
+     * @return  The class, or `SG_STACK_CLASSES` if the size is too large to be pooled.
+     */
+    uint32_t __sgStackClassOf(size_t size)
+    {
+        uint32_t k = 0;
+        while (k < SG_STACK_CLASSES && (SG_STACK_MIN << k) < size)
+            ++k;
+
+        return k;
+    }
+
+    /*
+     * @brief   Maps a stack with a guard page below it.
+     * @param   size the usable stack size, rounded up to whole pages
+     * @param   mapSize holds the total mapping size
+     * @return  The mapping base (the guard page), or `NULL` if failed.
+     */
+    void *__sgStackMap(size_t size, size_t *mapSize)
+    {
+        size_t page = __sgStackPoolGet()->page;
+        size = (size + page - 1) & ~(page - 1);
+
+        void *base = mmap(NULL, size + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE, -1, 0);
+        if (base == MAP_FAILED)
+            return NULL;
+
+        if (mprotect(base, page, PROT_NONE) != 0)
+        {
+            munmap(base, size + page);
+            return NULL;
+        }
+
+        *mapSize = size + page;
+        return base;
+    }
+
+    /*
+     * @brief   Takes a guard-paged stack from the pool, or maps a new one if none of its size class is cached.
+     * @param   size the usable stack size, rounded up to its size class
+     * @param   mapSize holds the total mapping size
+     * @return  The mapping base (the guard page), or `NULL` if failed. The usable stack starts one page above it.
+     */
+    void *__sgStackAcquire(size_t size, size_t *mapSize)
+    {
+        __sgStackPool *p = __sgStackPoolGet();
+        uint32_t k = __sgStackClassOf(size);
+        if (k == SG_STACK_CLASSES)
+            return __sgStackMap(size, mapSize);
+
+        __sgStackClass *c = &p->classes[k];
+        size_t usable = SG_STACK_MIN << k;
+
+        pthread_mutex_lock(&c->lock);
+        __sgStackFree *f = c->head;
+        if (f != NULL)
+            c->head = f->next;
+        pthread_mutex_unlock(&c->lock);
+
+        if (f == NULL)
+            return __sgStackMap(usable, mapSize);
+
+        __atomic_fetch_sub(&p->cached, usable + p->page, __ATOMIC_RELAXED);
+        *mapSize = usable + p->page;
+        return (char *)f - p->page;
+    }
+
+    /*
+     * @brief   Returns a stack to the pool, or unmaps it if the pool already caches its limit.
+     * @param   base the mapping base from `__sgStackAcquire()`
+     * @param   mapSize the total mapping size
+     * @return  None.
+     * @note    The stack must not be in use anymore, e.g. its thread must have been joined.
+     */
+    void __sgStackRelease(void *base, size_t mapSize)
+    {
+        if (base == NULL)
+            return;
+
+        __sgStackPool *p = __sgStackPoolGet();
+        size_t usable = mapSize - p->page;
+        uint32_t k = __sgStackClassOf(usable);
+
+        if (k == SG_STACK_CLASSES || (SG_STACK_MIN << k) != usable ||
+            __atomic_add_fetch(&p->cached, mapSize, __ATOMIC_RELAXED) > __atomic_load_n(&p->limit, __ATOMIC_RELAXED))
+        {
+            if (k < SG_STACK_CLASSES && (SG_STACK_MIN << k) == usable)
+                __atomic_fetch_sub(&p->cached, mapSize, __ATOMIC_RELAXED);
+            munmap(base, mapSize);
+            return;
+        }
+
+        __sgStackClass *c = &p->classes[k];
+        __sgStackFree *f = (__sgStackFree *)((char *)base + p->page);
+
+        pthread_mutex_lock(&c->lock);
+        f->next = c->head;
+        c->head = f;
+        pthread_mutex_unlock(&c->lock);
+    }
+
+    /*
+     * @brief   Sets how many bytes of unused routine stacks may be kept for reuse, and unmaps the cached stacks above it.
+     * @param   limit the limit in bytes, `0` to disable caching
+     * @return  None.
+     * @note    The default limit is `SG_STACK_CACHE_LIMIT`. The pool is shared by every runtime of the process.
+     */
+    void sgStackPoolSetLimit(size_t limit)
+    {
+        __sgStackPool *p = __sgStackPoolGet();
+        __atomic_store_n(&p->limit, limit, __ATOMIC_RELAXED);
+
+        for (uint32_t k = SG_STACK_CLASSES; k-- > 0 && __atomic_load_n(&p->cached, __ATOMIC_RELAXED) > limit;)
+        {
+            __sgStackClass *c = &p->classes[k];
+            size_t mapSize = (SG_STACK_MIN << k) + p->page;
+
+            while (__atomic_load_n(&p->cached, __ATOMIC_RELAXED) > limit)
+            {
+                pthread_mutex_lock(&c->lock);
+                __sgStackFree *f = c->head;
+                if (f != NULL)
+                    c->head = f->next;
+                pthread_mutex_unlock(&c->lock);
+
+                if (f == NULL)
+                    break;
+
+                __atomic_fetch_sub(&p->cached, mapSize, __ATOMIC_RELAXED);
+                munmap((char *)f - p->page, mapSize);
+            }
+        }
+    }
+
+    /*
+     * @brief   Retrieves how many bytes of unused routine stacks are cached for reuse.
+     * @param   none
+     * @return  The number of bytes, guard pages included.
+     */
+    size_t sgStackPoolCached()
+    {
+        return __atomic_load_n(&__sgStackPoolGet()->cached, __ATOMIC_RELAXED);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
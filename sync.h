@@ -0,0 +1,101 @@
+#ifndef __SEGO_SYNC_H
+#define __SEGO_SYNC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include "enums.h"
+
+#if defined(__GLIBC__) && !defined(__USE_MISC)
+#error "sego needs syscall(): define _DEFAULT_SOURCE (or _GNU_SOURCE), or include sego.h before any system header"
+#endif
+
+    /*
+     * @brief   Waits on a futex word as long as it holds the expected value.
+     * @param   addr the futex word
+     * @param   val the expected value
+     * @param   timeout the relative timeout, `-1` for infinite wait
+     * @return  `SG_TIMEOUT` if timeout. `SG_OK` if woken up (possibly spuriously) or the value has changed.
+     * @note    Multiply the timeout with the desired time unit, e.g. 500L * `SG_TIME_MS` for 500ms timeout duration.
+     */
+    sgReturnType __sgFutexWait(uint32_t *addr, uint32_t val, int64_t timeout)
+    {
+        struct timespec ts;
+        struct timespec *tsp = NULL;
+
+        if (timeout >= 0)
+        {
+            ts.tv_sec = timeout / SG_TIME_S;
+            ts.tv_nsec = timeout % SG_TIME_S;
+            tsp = &ts;
+        }
+
+        if (syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, tsp, NULL, 0) == -1 && errno == ETIMEDOUT)
+            return SG_TIMEOUT;
+
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Wakes threads waiting on a futex word.
+     * @param   addr the futex word
+     * @param   n the maximum number of threads to wake
+     * @return  None.
+     */
+    void __sgFutexWake(uint32_t *addr, int n)
+    {
+        syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+    }
+
+    /*
+     * @brief   Hints the CPU that the caller is spinning.
+     * @param   none
+     * @return  None.
+     */
+    void __sgCpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __asm__ __volatile__("pause" ::: "memory");
+#elif defined(__aarch64__)
+        __asm__ __volatile__("yield" ::: "memory");
+#else
+        __asm__ __volatile__("" ::: "memory");
+#endif
+    }
+
+    /*
+     * @brief   Retrieves the number of online CPUs.
+     * @param   none
+     * @return  The number of online CPUs, at least `1`.
+     */
+    uint32_t __sgNumCpus()
+    {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        return (n < 1) ? 1U : (uint32_t)n;
+    }
+
+    /*
+     * @brief   Retrieves the monotonic clock time.
+     * @param   none
+     * @return  The time in nanoseconds.
+     */
+    int64_t __sgMonoNanos()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)(ts.tv_sec * 1000000000LL + ts.tv_nsec);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "sego.h"
+#include <stdio.h>
+
+#define ITEMS 100000
+#define SENDERS 4
+#define RECEIVERS 4
+
+static sgChan *ch;
+static int64_t received = 0;
+static uint32_t count = 0;
+
+/*
+ * @brief   Checks that a ring asked for a single item never overwrites an item that was not popped, and reports empty and full without spinning.
+ * @param   none
+ * @return  The number of mismatches.
+ */
+int checkSingleSlot()
+{
+    int bad = 0, v = 0;
+
+    __sgMpmc *q = __sgMpmcCreate(sizeof(int), 1);
+    if (q == NULL)
+        return 1;
+
+    for (int i = 1; i <= 3; ++i)
+    {
+        if (!__sgMpmcRoom(q) || !__sgMpmcPush(q, &i))
+            ++bad;
+        if (!__sgMpmcReady(q) || !__sgMpmcPop(q, &v) || v != i)
+            ++bad;
+    }
+
+    if (__sgMpmcReady(q) || __sgMpmcPop(q, &v))
+        ++bad;
+
+    int pushed = 0;
+    while (pushed < 64 && __sgMpmcPush(q, &pushed))
+        ++pushed;
+
+    if (pushed == 0 || pushed == 64 || __sgMpmcRoom(q))
+        ++bad;
+
+    for (int i = 0; i < pushed; ++i)
+        if (!__sgMpmcPop(q, &v) || v != i)
+            ++bad;
+
+    if (__sgMpmcReady(q))
+        ++bad;
+
+    __sgMpmcDestroy(q);
+    return bad;
+}
+
+/*
+ * @brief   Sends its share of the items.
+ * @param   arg the sender index
+ * @return  A void pointer.
+ */
+void *sender(void *arg)
+{
+    for (int i = (int)(intptr_t)arg; i < ITEMS; i += SENDERS)
+        sgChanIn(ch, &i);
+    return NULL;
+}
+
+/*
+ * @brief   Receives until every item has been received.
+ * @param   arg unused
+ * @return  A void pointer.
+ */
+void *receiver(void *arg)
+{
+    (void)arg;
+
+    int v;
+    while (sgChanOutTimed(ch, &v, 50LL * SG_TIME_MS) == SG_OK)
+    {
+        __atomic_fetch_add(&received, v, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&count, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+/*
+ * @brief   Passes every item through an MPMC channel with a single slot, with several senders and receivers on a coroutine runtime.
+ * @param   none
+ * @return  The number of mismatches.
+ */
+int checkSingleSlotChannel()
+{
+    sgConfig cfg = sgConfigDefault();
+    cfg.mode = SG_MODE_COROUTINE;
+
+    sgRuntime *rt = sgRuntimeCreate(&cfg);
+    ch = sgChanMakeMPMC(sizeof(int), 1);
+    if (rt == NULL || ch == NULL)
+        return 1;
+
+    for (int i = 0; i < SENDERS; ++i)
+        segoOn(rt, sender, (void *)(intptr_t)i);
+    for (int i = 0; i < RECEIVERS; ++i)
+        segoOn(rt, receiver, NULL);
+
+    sgRuntimeShutdown(rt, -1, NULL);
+    sgChanDestroy(ch);
+
+    int bad = (count == ITEMS) ? 0 : 1;
+    if (received != (int64_t)ITEMS * (ITEMS - 1) / 2)
+        ++bad;
+    return bad;
+}
+
+int main()
+{
+    int bad = checkSingleSlot() + checkSingleSlotChannel();
+    printf("mpmc: %s (%d mismatches)\n", (bad == 0) ? "ok" : "FAILED", bad);
+    return (bad == 0) ? 0 : 1;
+}
\ No newline at end of file
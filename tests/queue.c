@@ -0,0 +1,105 @@
+#include "sego.h"
+#include "bench/linked_queue.h"
+#include <stdio.h>
+
+#define TRIALS 200
+#define OPS 5000
+#define MAX_ITEM 5000
+
+/*
+ * @brief   Checks the drop-oldest behavior of a full queue, and the order of the items left.
+ * @param   none
+ * @return  The number of mismatches.
+ */
+int checkDropOldest()
+{
+    int bad = 0, v;
+
+    sgQueue *q = sgQueueCreate(sizeof(int), 5);
+    for (int i = 0; i < 12; ++i)
+        if ((sgQueueQueue(q, &i) == SG_QUEUE_FULL) != (i >= 5))
+            ++bad;
+
+    for (int i = 7; i < 12; ++i)
+        if (sgQueueDequeue(q, &v) != SG_OK || v != i)
+            ++bad;
+
+    if (sgQueueDequeue(q, &v) != SG_NOTHING)
+        ++bad;
+
+    sgQueueDestroy(q);
+    return bad;
+}
+
+/*
+ * @brief   Checks that a queue with a large bufferSize grows its ring on demand and keeps the order.
+ * @param   none
+ * @return  The number of mismatches.
+ */
+int checkGrowth()
+{
+    int bad = 0, v;
+
+    sgQueue *q = sgQueueCreate(sizeof(int), (size_t)1 << 40);
+    for (int i = 0; i < 100000; ++i)
+        if (sgQueueQueue(q, &i) != SG_OK)
+            ++bad;
+
+    for (int i = 0; i < 100000; ++i)
+        if (sgQueueDequeue(q, &v) != SG_OK || v != i)
+            ++bad;
+
+    sgQueueDestroy(q);
+    return bad;
+}
+
+/*
+ * @brief   Runs random queues and dequeues of random-sized items against both the ring-backed `sgQueue` and the linked-list queue it replaced, and compares every result.
+ * @param   none
+ * @return  The number of mismatches.
+ */
+int checkAgainstLinked()
+{
+    static char in[MAX_ITEM], a[MAX_ITEM], b[MAX_ITEM];
+    int bad = 0;
+
+    srand(1);
+    for (int trial = 0; trial < TRIALS; ++trial)
+    {
+        size_t itemSize = 1 + rand() % MAX_ITEM, cap = 1 + rand() % 200;
+        sgLinkedQueue *l = sgLinkedQueueCreate(itemSize, cap);
+        sgQueue *q = sgQueueCreate(itemSize, cap);
+
+        for (int op = 0; op < OPS; ++op)
+        {
+            if (rand() % 3 != 0)
+            {
+                for (size_t k = 0; k < itemSize; ++k)
+                    in[k] = (char)rand();
+                if (sgLinkedQueueQueue(l, in) != sgQueueQueue(q, in))
+                    ++bad;
+            }
+            else
+            {
+                sgReturnType r = sgLinkedQueueDequeue(l, a);
+                if (r != sgQueueDequeue(q, b) || (r == SG_OK && memcmp(a, b, itemSize) != 0))
+                    ++bad;
+            }
+
+            if (l->waiting != q->waiting)
+                ++bad;
+        }
+
+        sgLinkedQueueDestroy(l);
+        sgQueueDestroy(q);
+    }
+
+    return bad;
+}
+
+int main()
+{
+    int bad = checkDropOldest() + checkGrowth() + checkAgainstLinked();
+    printf("queue: %s (%d mismatches)\n", (bad == 0) ? "ok" : "FAILED", bad);
+    return (bad == 0) ? 0 : 1;
+}
\ No newline at end of file
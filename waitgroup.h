@@ -0,0 +1,198 @@
+#ifndef __SEGO_WAITGROUP_H
+#define __SEGO_WAITGROUP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "enums.h"
+#include "sync.h"
+#include "park.h"
+
+    typedef struct
+    {
+        int64_t count;
+        uint32_t nWaiters;
+        uint32_t busy;
+        pthread_mutex_t lock;
+        __sgWaitList waiters;
+    } sgWaitGroup;
+
+    /*
+     * @brief   Initializes a wait group in place.
+     * @param   wg the wait group
+     * @return  `SG_ERR_PTHREAD` if the lock could not be initialized. `SG_OK` if ok.
+     */
+    sgReturnType __sgWaitGroupInit(sgWaitGroup *wg)
+    {
+        if (pthread_mutex_init(&wg->lock, NULL) != 0)
+            return SG_ERR_PTHREAD;
+
+        wg->count = 0;
+        wg->nWaiters = 0;
+        wg->busy = 0;
+        wg->waiters.head = NULL;
+        wg->waiters.tail = NULL;
+        return SG_OK;
+    }
+
+    /*
+     * @brief   Releases a wait group initialized in place, once no `sgWaitGroupAdd()` call is still touching it.
+     * @param   wg the wait group
+     * @return  None.
+     */
+    void __sgWaitGroupDeinit(sgWaitGroup *wg)
+    {
+        while (__atomic_load_n(&wg->busy, __ATOMIC_ACQUIRE) > 0)
+            __sgCpuRelax();
+
+        pthread_mutex_destroy(&wg->lock);
+    }
+
+    /*
+     * @brief   Creates new wait group, with its counter at zero.
+     * @param   none
+     * @return  The pointer to the wait group (`sgWaitGroup`) instance.
+     */
+    sgWaitGroup *sgWaitGroupCreate()
+    {
+        sgWaitGroup *wg = (sgWaitGroup *)malloc(sizeof(sgWaitGroup));
+        if (!wg)
+            return NULL;
+
+        if (__sgWaitGroupInit(wg) != SG_OK)
+        {
+            free(wg);
+            return NULL;
+        }
+
+        return wg;
+    }
+
+    /*
+     * @brief   Adds a delta, which may be negative, to the wait group counter. Waiters are released when it drops to zero.
+     * @param   wg the wait group instance
+     * @param   delta the delta
+     * @return  `SG_ERR_NULLPTR` if the wait group is a `NULL`. `SG_ERR_INVALID` if the counter would become negative, in which case it is left unchanged. `SG_OK` if ok.
+     */
+    sgReturnType sgWaitGroupAdd(sgWaitGroup *wg, int64_t delta)
+    {
+        if (wg == NULL)
+            return SG_ERR_NULLPTR;
+
+        __atomic_fetch_add(&wg->busy, 1, __ATOMIC_SEQ_CST);
+
+        sgReturnType ret = SG_OK;
+        int64_t v = __atomic_add_fetch(&wg->count, delta, __ATOMIC_SEQ_CST);
+        if (v < 0)
+        {
+            __atomic_fetch_sub(&wg->count, delta, __ATOMIC_SEQ_CST);
+            ret = SG_ERR_INVALID;
+        }
+        else if (v == 0 && __atomic_load_n(&wg->nWaiters, __ATOMIC_SEQ_CST) > 0)
+        {
+            pthread_mutex_lock(&wg->lock);
+            __sgWaitListWakeAll(&wg->waiters, wg);
+            pthread_mutex_unlock(&wg->lock);
+        }
+
+        __atomic_fetch_sub(&wg->busy, 1, __ATOMIC_RELEASE);
+        return ret;
+    }
+
+    /*
+     * @brief   Decrements the wait group counter by one.
+     * @param   wg the wait group instance
+     * @return  `SG_ERR_NULLPTR` if the wait group is a `NULL`. `SG_ERR_INVALID` if the counter is already zero. `SG_OK` if ok.
+     */
+    sgReturnType sgWaitGroupDone(sgWaitGroup *wg)
+    {
+        return sgWaitGroupAdd(wg, -1);
+    }
+
+    /*
+     * @brief   Waits until the wait group counter drops to zero, with timeout.
+     * @param   wg the wait group instance
+     * @param   timeout the timeout, `-1` for infinite wait
+     * @return  `SG_ERR_NULLPTR` if the wait group is a `NULL`. `SG_TIMEOUT` if timeout. `SG_OK` if ok.
+     * @note    Inside a coroutine, this suspends only the calling routine.
+     * @note    Multiply the timeout with the desired time unit, e.g. 500L * `SG_TIME_MS` for 500ms timeout duration.
+     */
+    sgReturnType sgWaitGroupWaitTimed(sgWaitGroup *wg, int64_t timeout)
+    {
+        if (wg == NULL)
+            return SG_ERR_NULLPTR;
+
+        if (__atomic_load_n(&wg->count, __ATOMIC_ACQUIRE) == 0)
+            return SG_OK;
+
+        int64_t deadline = (timeout >= 0) ? __sgMonoNanos() + timeout : -1;
+        sgReturnType ret = SG_OK;
+
+        pthread_mutex_lock(&wg->lock);
+        __atomic_fetch_add(&wg->nWaiters, 1, __ATOMIC_SEQ_CST);
+
+        while (__atomic_load_n(&wg->count, __ATOMIC_SEQ_CST) != 0)
+        {
+            int64_t remaining = -1;
+            if (deadline >= 0)
+            {
+                remaining = deadline - __sgMonoNanos();
+                if (remaining <= 0)
+                {
+                    ret = SG_TIMEOUT;
+                    break;
+                }
+            }
+
+            __sgParker p;
+            __sgWaitLink link;
+            __sgParkerInit(&p);
+            __sgWaitListAdd(&wg->waiters, &link, &p, wg);
+            __sgParkerWait(&p, &wg->lock, remaining);
+
+            pthread_mutex_lock(&wg->lock);
+            __sgWaitListRemove(&wg->waiters, &link);
+        }
+
+        __atomic_fetch_sub(&wg->nWaiters, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&wg->lock);
+
+        return ret;
+    }
+
+    /*
+     * @brief   Waits until the wait group counter drops to zero.
+     * @param   wg the wait group instance
+     * @return  `SG_ERR_NULLPTR` if the wait group is a `NULL`. `SG_OK` if ok.
+     * @note    Inside a coroutine, this suspends only the calling routine.
+     */
+    sgReturnType sgWaitGroupWait(sgWaitGroup *wg)
+    {
+        return sgWaitGroupWaitTimed(wg, -1);
+    }
+
+    /*
+     * @brief   Destroys the wait group.
+     * @param   wg the wait group instance
+     * @return  None.
+     * @note    No routine may be waiting on the wait group anymore.
+     */
+    void sgWaitGroupDestroy(sgWaitGroup *wg)
+    {
+        if (wg == NULL)
+            return;
+
+        __sgWaitGroupDeinit(wg);
+        free(wg);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file